@@ -0,0 +1,489 @@
+/*
+ * xad-forge Backend Benchmarks
+ *
+ * Measures, for graphs of several sizes and operation mixes:
+ * - Compile time of ForgeBackend, ForgeBackendAVX, ForgeBackendAVX512 and
+ *   ForgeBackendAuto (widest instruction set of the host)
+ * - Forward+backward throughput (evaluations per second) of these backends,
+ *   XAD's tape (record and reverse sweep per evaluation) and XAD's JIT graph
+ *   interpreter
+ * - Per-evaluation overhead of moving inputs and gradients through the Forge
+ *   C API one input at a time versus in bulk
+ * - Share of forge_buffer_clear_gradients() in the cost of one forward+backward
+ *   execution
+ *
+ * Arguments of the graph benchmarks are {operation mix, operations per graph}.
+ * Run with --benchmark_filter=<regex> to select, and
+ * --benchmark_format=json to compare runs.
+ *
+ * Copyright (c) 2025 The xad-forge Authors
+ * https://github.com/da-roth/xad-forge
+ * SPDX-License-Identifier: Zlib
+ */
+
+#include <xad-forge/CpuFeatures.hpp>
+#include <xad-forge/ForgeBackend.hpp>
+#include <xad-forge/ForgeBackendAVX.hpp>
+#include <xad-forge/ForgeBackendAVX512.hpp>
+#include <xad-forge/ForgeBackendAuto.hpp>
+#include <XAD/XAD.hpp>
+#include <XAD/JITGraphInterpreter.hpp>
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::size_t kNumInputs = 8;
+
+enum Mix
+{
+    Arithmetic = 0,      // add, sub, mul, div
+    Transcendental = 1,  // exp, log, sin, cos, sqrt
+    Mixed = 2            // path-like: drift, diffusion, exp and max
+};
+
+const char* mixName(int mix)
+{
+    switch (mix)
+    {
+        case Arithmetic:
+            return "arithmetic";
+        case Transcendental:
+            return "transcendental";
+        default:
+            return "mixed";
+    }
+}
+
+// One output computed from kNumInputs inputs with about numOps operations
+template <class T>
+T workload(const std::vector<T>& x, int mix, std::size_t numOps)
+{
+    using std::cos; using std::exp; using std::log; using std::max; using std::sin; using std::sqrt;
+
+    T y = x[0];
+    std::size_t ops = 0;
+    for (std::size_t i = 0; ops < numOps; ++i)
+    {
+        const T& a = x[i % kNumInputs];
+        const T& b = x[(i + 3) % kNumInputs];
+        switch (mix)
+        {
+            case Arithmetic:
+                y = y * 0.999 + a * b - a / (b + 2.0);
+                ops += 6;
+                break;
+            case Transcendental:
+                y = sin(y) * 0.5 + exp(a * 0.01) + log(b * b + 1.0) + sqrt(cos(y) + 2.0);
+                ops += 12;
+                break;
+            default:
+                y = y * exp(0.001 * a + 0.02 * b * 0.1) + max(y - 1.0, 0.0) * 0.001;
+                ops += 10;
+                break;
+        }
+    }
+    return y;
+}
+
+std::vector<double> inputValues()
+{
+    std::vector<double> values(kNumInputs);
+    for (std::size_t i = 0; i < kNumInputs; ++i)
+        values[i] = 0.5 + 0.1 * static_cast<double>(i);
+    return values;
+}
+
+// Record the workload and return a copy of the graph, so that no recording
+// stays active while other benchmarks record
+xad::JITGraph recordGraph(int mix, std::size_t numOps)
+{
+    const std::vector<double> values = inputValues();
+    xad::JITCompiler<double, 1> jit;
+    std::vector<xad::AD> x(values.begin(), values.end());
+    for (std::size_t i = 0; i < kNumInputs; ++i)
+        jit.registerInput(x[i]);
+    jit.newRecording();
+    xad::AD y = workload(x, mix, numOps);
+    jit.registerOutput(y);
+    return jit.getGraph();
+}
+
+void setCounters(benchmark::State& state, const xad::JITGraph& graph, std::size_t lanes)
+{
+    state.SetLabel(mixName(static_cast<int>(state.range(0))));
+    state.counters["nodes"] = static_cast<double>(graph.nodeCount());
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * lanes));
+}
+
+bool skipWithoutAVX2(benchmark::State& state)
+{
+    if (xad::forge::CpuFeatures::host().avx2)
+        return false;
+    state.SkipWithError("AVX2 not supported by this CPU");
+    return true;
+}
+
+#if XAD_FORGE_HAS_AVX512
+bool skipWithoutAVX512(benchmark::State& state)
+{
+    if (xad::forge::CpuFeatures::host().avx512f)
+        return false;
+    state.SkipWithError("AVX-512F not supported by this CPU");
+    return true;
+}
+#endif
+
+// =============================================================================
+// Compile time
+// =============================================================================
+
+template <class Backend>
+void compileBackend(benchmark::State& state)
+{
+    const xad::JITGraph graph = recordGraph(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+    for (auto _ : state)
+    {
+        Backend backend;
+        backend.compile(graph);
+        benchmark::DoNotOptimize(backend.kernel());
+    }
+    setCounters(state, graph, 1);
+}
+
+void BM_CompileForgeBackend(benchmark::State& state)
+{
+    compileBackend<xad::forge::ForgeBackend<double>>(state);
+}
+
+void BM_CompileForgeBackendAVX(benchmark::State& state)
+{
+    if (skipWithoutAVX2(state))
+        return;
+    compileBackend<xad::forge::ForgeBackendAVX<double>>(state);
+}
+
+#if XAD_FORGE_HAS_AVX512
+void BM_CompileForgeBackendAVX512(benchmark::State& state)
+{
+    if (skipWithoutAVX512(state))
+        return;
+    compileBackend<xad::forge::ForgeBackendAVX512<double>>(state);
+}
+#endif
+
+void BM_CompileForgeBackendAuto(benchmark::State& state)
+{
+    compileBackend<xad::forge::ForgeBackendAuto<double>>(state);
+}
+
+void BM_CompileInterpreter(benchmark::State& state)
+{
+    const xad::JITGraph graph = recordGraph(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+    for (auto _ : state)
+    {
+        xad::JITGraphInterpreter<double> interpreter;
+        interpreter.compile(graph);
+        benchmark::DoNotOptimize(&interpreter);
+    }
+    setCounters(state, graph, 1);
+}
+
+// =============================================================================
+// Throughput (forward + backward, all lanes)
+// =============================================================================
+
+template <class Backend>
+void evaluateBackend(benchmark::State& state)
+{
+    const xad::JITGraph graph = recordGraph(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+    Backend backend;
+    backend.compile(graph);
+
+    const std::size_t width = backend.vectorWidth();
+    const std::vector<double> values = inputValues();
+    std::vector<double> lanes(width), outputs(width), gradients(kNumInputs * width);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < kNumInputs; ++i)
+        {
+            std::fill(lanes.begin(), lanes.end(), values[i]);
+            backend.setInput(i, lanes.data());
+        }
+        backend.forwardAndBackward(outputs.data(), gradients.data());
+        benchmark::DoNotOptimize(gradients.data());
+    }
+    setCounters(state, graph, width);
+}
+
+void BM_EvaluateForgeBackend(benchmark::State& state)
+{
+    evaluateBackend<xad::forge::ForgeBackend<double>>(state);
+}
+
+void BM_EvaluateForgeBackendAVX(benchmark::State& state)
+{
+    if (skipWithoutAVX2(state))
+        return;
+    evaluateBackend<xad::forge::ForgeBackendAVX<double>>(state);
+}
+
+#if XAD_FORGE_HAS_AVX512
+void BM_EvaluateForgeBackendAVX512(benchmark::State& state)
+{
+    if (skipWithoutAVX512(state))
+        return;
+    evaluateBackend<xad::forge::ForgeBackendAVX512<double>>(state);
+}
+#endif
+
+void BM_EvaluateForgeBackendAuto(benchmark::State& state)
+{
+    evaluateBackend<xad::forge::ForgeBackendAuto<double>>(state);
+}
+
+void BM_EvaluateInterpreter(benchmark::State& state)
+{
+    const xad::JITGraph graph = recordGraph(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+    xad::JITGraphInterpreter<double> interpreter;
+    interpreter.compile(graph);
+
+    const std::vector<double> values = inputValues();
+    double output = 0.0;
+    std::vector<double> gradients(kNumInputs);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < kNumInputs; ++i)
+            interpreter.setInput(i, &values[i]);
+        interpreter.forwardAndBackward(&output, gradients.data());
+        benchmark::DoNotOptimize(gradients.data());
+    }
+    setCounters(state, graph, 1);
+}
+
+void BM_EvaluateTape(benchmark::State& state)
+{
+    const int mix = static_cast<int>(state.range(0));
+    const std::size_t numOps = static_cast<std::size_t>(state.range(1));
+    const xad::JITGraph graph = recordGraph(mix, numOps);
+
+    const std::vector<double> values = inputValues();
+    xad::Tape<double> tape;
+    for (auto _ : state)
+    {
+        std::vector<xad::AD> x(values.begin(), values.end());
+        for (std::size_t i = 0; i < kNumInputs; ++i)
+            tape.registerInput(x[i]);
+        tape.newRecording();
+        xad::AD y = workload(x, mix, numOps);
+        tape.registerOutput(y);
+        xad::derivative(y) = 1.0;
+        tape.computeAdjoints();
+        benchmark::DoNotOptimize(xad::derivative(x[0]));
+    }
+    setCounters(state, graph, 1);
+}
+
+// =============================================================================
+// Transfer overhead (many inputs, cheap graph)
+// =============================================================================
+
+// Sum of neighbouring products of numInputs inputs
+xad::JITGraph recordWideGraph(std::size_t numInputs)
+{
+    xad::JITCompiler<double, 1> jit;
+    std::vector<xad::AD> x(numInputs);
+    for (std::size_t i = 0; i < numInputs; ++i)
+    {
+        x[i] = 0.01 * static_cast<double>(i);
+        jit.registerInput(x[i]);
+    }
+    jit.newRecording();
+    xad::AD y = 0.0;
+    for (std::size_t i = 0; i + 1 < numInputs; ++i)
+        y = y + x[i] * x[i + 1];
+    jit.registerOutput(y);
+    return jit.getGraph();
+}
+
+// setInput() per input, as before setInputs() existed
+template <class Backend>
+void transferPerInput(benchmark::State& state)
+{
+    const std::size_t numInputs = static_cast<std::size_t>(state.range(0));
+    Backend backend;
+    backend.compile(recordWideGraph(numInputs));
+    const std::size_t width = backend.vectorWidth();
+    std::vector<double> inputs(numInputs * width, 0.5), outputs(width), gradients(numInputs * width);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < numInputs; ++i)
+            backend.setInput(i, &inputs[i * width]);
+        backend.forwardAndBackward(outputs.data(), gradients.data());
+        benchmark::DoNotOptimize(gradients.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * width));
+}
+
+template <class Backend>
+void transferBulk(benchmark::State& state)
+{
+    const std::size_t numInputs = static_cast<std::size_t>(state.range(0));
+    Backend backend;
+    backend.compile(recordWideGraph(numInputs));
+    const std::size_t width = backend.vectorWidth();
+    std::vector<double> inputs(numInputs * width, 0.5), outputs(width), gradients(numInputs * width);
+    for (auto _ : state)
+    {
+        backend.setInputs(inputs.data());
+        backend.forwardAndBackward(outputs.data(), gradients.data());
+        benchmark::DoNotOptimize(gradients.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * width));
+}
+
+// Gradient gather alone: one forge_buffer_get_gradient_lanes call per input
+// (the previous forwardAndBackward()) versus one call for all inputs
+void gatherGradients(benchmark::State& state, bool bulk)
+{
+    const std::size_t numInputs = static_cast<std::size_t>(state.range(0));
+    std::shared_ptr<const xad::forge::ForgeKernel> kernel =
+        xad::forge::ForgeKernel::compile(recordWideGraph(numInputs), FORGE_INSTRUCTION_SET_SSE2_SCALAR);
+    ForgeBufferHandle buffer = kernel->createBuffer();
+    forge_execute(kernel->handle(), buffer);
+
+    const std::vector<uint32_t>& ids = kernel->inputIds();
+    const std::size_t width = kernel->vectorWidth();
+    std::vector<double> gradients(numInputs * width);
+    for (auto _ : state)
+    {
+        if (bulk)
+        {
+            forge_buffer_get_gradient_lanes(buffer, ids.data(), ids.size(), gradients.data());
+        }
+        else
+        {
+            for (std::size_t i = 0; i < ids.size(); ++i)
+                forge_buffer_get_gradient_lanes(buffer, &ids[i], 1, &gradients[i * width]);
+        }
+        benchmark::DoNotOptimize(gradients.data());
+    }
+    forge_buffer_destroy(buffer);
+}
+
+void BM_TransferPerInputForgeBackend(benchmark::State& state)
+{
+    transferPerInput<xad::forge::ForgeBackend<double>>(state);
+}
+
+void BM_TransferBulkForgeBackend(benchmark::State& state)
+{
+    transferBulk<xad::forge::ForgeBackend<double>>(state);
+}
+
+void BM_TransferPerInputForgeBackendAVX(benchmark::State& state)
+{
+    if (skipWithoutAVX2(state))
+        return;
+    transferPerInput<xad::forge::ForgeBackendAVX<double>>(state);
+}
+
+void BM_TransferBulkForgeBackendAVX(benchmark::State& state)
+{
+    if (skipWithoutAVX2(state))
+        return;
+    transferBulk<xad::forge::ForgeBackendAVX<double>>(state);
+}
+
+void BM_GatherGradientsPerInput(benchmark::State& state)
+{
+    gatherGradients(state, false);
+}
+
+void BM_GatherGradientsBulk(benchmark::State& state)
+{
+    gatherGradients(state, true);
+}
+
+// =============================================================================
+// Gradient clearing
+// =============================================================================
+
+// Times the gradient clear alone, the execution alone, or both. Executing
+// without clearing gives wrong gradients but the same amount of work, so the
+// difference of the last two is the clear's share of an evaluation.
+void clearAndExecute(benchmark::State& state, bool isAvx, bool clear, bool execute)
+{
+    if (isAvx && skipWithoutAVX2(state))
+        return;
+    const xad::JITGraph graph = recordGraph(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+    std::shared_ptr<const xad::forge::ForgeKernel> kernel = xad::forge::ForgeKernel::compile(
+        graph, isAvx ? FORGE_INSTRUCTION_SET_AVX2_PACKED : FORGE_INSTRUCTION_SET_SSE2_SCALAR);
+    ForgeBufferHandle buffer = kernel->createBuffer();
+    for (auto _ : state)
+    {
+        if (clear)
+            forge_buffer_clear_gradients(buffer);
+        if (execute)
+            forge_execute(kernel->handle(), buffer);
+    }
+    forge_buffer_destroy(buffer);
+    setCounters(state, graph, kernel->vectorWidth());
+}
+
+void BM_ClearGradientsForgeBackend(benchmark::State& state) { clearAndExecute(state, false, true, false); }
+void BM_ExecuteOnlyForgeBackend(benchmark::State& state) { clearAndExecute(state, false, false, true); }
+void BM_ClearAndExecuteForgeBackend(benchmark::State& state) { clearAndExecute(state, false, true, true); }
+void BM_ClearGradientsForgeBackendAVX(benchmark::State& state) { clearAndExecute(state, true, true, false); }
+void BM_ExecuteOnlyForgeBackendAVX(benchmark::State& state) { clearAndExecute(state, true, false, true); }
+void BM_ClearAndExecuteForgeBackendAVX(benchmark::State& state) { clearAndExecute(state, true, true, true); }
+
+void graphArgs(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"mix", "ops"});
+    for (int mix = Arithmetic; mix <= Mixed; ++mix)
+    {
+        for (int64_t ops : {256, 4096, 65536})
+            b->Args({mix, ops});
+    }
+}
+
+} // anonymous namespace
+
+BENCHMARK(BM_CompileForgeBackend)->Apply(graphArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CompileForgeBackendAVX)->Apply(graphArgs)->Unit(benchmark::kMillisecond);
+#if XAD_FORGE_HAS_AVX512
+BENCHMARK(BM_CompileForgeBackendAVX512)->Apply(graphArgs)->Unit(benchmark::kMillisecond);
+#endif
+BENCHMARK(BM_CompileForgeBackendAuto)->Apply(graphArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CompileInterpreter)->Apply(graphArgs)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_EvaluateForgeBackend)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_EvaluateForgeBackendAVX)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+#if XAD_FORGE_HAS_AVX512
+BENCHMARK(BM_EvaluateForgeBackendAVX512)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+#endif
+BENCHMARK(BM_EvaluateForgeBackendAuto)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_EvaluateInterpreter)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_EvaluateTape)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_TransferPerInputForgeBackend)->Arg(16)->Arg(161)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TransferBulkForgeBackend)->Arg(16)->Arg(161)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TransferPerInputForgeBackendAVX)->Arg(16)->Arg(161)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TransferBulkForgeBackendAVX)->Arg(16)->Arg(161)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GatherGradientsPerInput)->Arg(16)->Arg(161)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GatherGradientsBulk)->Arg(16)->Arg(161)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_ClearGradientsForgeBackend)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ExecuteOnlyForgeBackend)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ClearAndExecuteForgeBackend)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ClearGradientsForgeBackendAVX)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ExecuteOnlyForgeBackendAVX)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ClearAndExecuteForgeBackendAVX)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
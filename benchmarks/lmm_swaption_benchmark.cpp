@@ -0,0 +1,608 @@
+/*
+ * xad-forge LIBOR Market Model Swaption Benchmark
+ *
+ * Prices a portfolio of 15 European swaptions under a one-factor lognormal
+ * LIBOR Market Model by Monte Carlo and computes 161 sensitivities (a
+ * parallel curve shift, 80 initial forward rates and 80 volatilities) with:
+ * - FD:      central finite differences (bump and revalue, small path counts)
+ * - XAD:     XAD tape, recording and reverse sweep per path
+ * - JIT:     one recording through xad::JITCompiler, compiled with ForgeBackend
+ * - JIT-AVX: the same recording compiled with ForgeBackendAVX (4 paths at once)
+ * - JIT-AVX512: the same recording compiled with ForgeBackendAVX512 (8 paths
+ *   at once), if the Forge C API and the CPU support AVX-512
+ * - JIT-SEG: the same recording compiled with SegmentedForgeBackend in scalar
+ *   mode, cut into partitions of at most --segment-nodes nodes
+ *
+ * All methods use the same random numbers. JIT timings include recording and
+ * compilation; a second table splits JIT and JIT-SEG into compile and
+ * evaluation time, showing the per-segment cost of the segmented backend.
+ * The sensitivities of every method are cross-checked against the tape, and
+ * the results are written as JSON.
+ *
+ * Usage:
+ *   xad-forge-lmm-benchmark [--paths 10,100,1000] [--warmup 2] [--repetitions 3]
+ *                           [--fd-max-paths 1000] [--segment-nodes 2000]
+ *                           [--json results.json]
+ *
+ * Copyright (c) 2025 The xad-forge Authors
+ * https://github.com/da-roth/xad-forge
+ * SPDX-License-Identifier: Zlib
+ */
+
+#include <xad-forge/CpuFeatures.hpp>
+#include <xad-forge/ForgeBackend.hpp>
+#include <xad-forge/ForgeBackendAVX.hpp>
+#include <xad-forge/ForgeBackendAVX512.hpp>
+#include <xad-forge/SegmentedForgeBackend.hpp>
+#include <XAD/XAD.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// =============================================================================
+// Model and portfolio
+// =============================================================================
+
+struct Swaption
+{
+    int expiry;     // index of the expiry date T_e
+    int end;        // index of the swap end date T_m
+    double strike;
+};
+
+struct LmmSetup
+{
+    int numRates;        // forward rates L_0 .. L_{n-1} on [T_i, T_i + delta]
+    double delta;        // accrual period in years
+    int numSteps;        // simulated periods, up to the last expiry
+    std::vector<double> market;  // [shift, L_0..L_{n-1}, vol_0..vol_{n-1}]
+    std::vector<Swaption> swaptions;  // sorted by expiry
+
+    std::size_t numSensitivities() const { return market.size(); }
+};
+
+LmmSetup makeSetup()
+{
+    LmmSetup s;
+    s.numRates = 80;
+    s.delta = 0.5;
+
+    s.market.push_back(0.0);  // parallel shift of all initial forwards
+    for (int i = 0; i < s.numRates; ++i)
+        s.market.push_back(0.03 + 0.0004 * i);
+    for (int i = 0; i < s.numRates; ++i)
+        s.market.push_back(0.15 + 0.08 * std::exp(-0.1 * s.delta * i));
+
+    // Swap end dates of 4, 8, 20, 28 and 40 years, each with expiries at a
+    // quarter, half and three quarters of the way
+    const int maturities[] = {4, 8, 20, 28, 40};
+    for (int maturity : maturities)
+    {
+        const int end = static_cast<int>(maturity / s.delta);
+        for (int q = 1; q <= 3; ++q)
+            s.swaptions.push_back(Swaption{q * end / 4, end, 0.04});
+    }
+    std::sort(s.swaptions.begin(), s.swaptions.end(),
+              [](const Swaption& a, const Swaption& b) { return a.expiry < b.expiry; });
+    s.numSteps = s.swaptions.back().expiry;
+    return s;
+}
+
+// Standard normals for one path; a fixed generator and Box-Muller keep them
+// identical across methods, platforms and standard libraries
+void pathNormals(std::uint64_t seed, std::size_t path, std::vector<double>& z)
+{
+    std::mt19937_64 gen(seed ^ (static_cast<std::uint64_t>(path) * 0x9E3779B97F4A7C15ULL));
+    const double scale = 1.0 / 18446744073709551616.0;  // 2^-64
+    for (std::size_t k = 0; k < z.size(); k += 2)
+    {
+        const double u1 = (static_cast<double>(gen()) + 0.5) * scale;
+        const double u2 = (static_cast<double>(gen()) + 0.5) * scale;
+        const double r = std::sqrt(-2.0 * std::log(u1));
+        z[k] = r * std::cos(6.283185307179586 * u2);
+        if (k + 1 < z.size())
+            z[k + 1] = r * std::sin(6.283185307179586 * u2);
+    }
+}
+
+// Value of a swaption at its expiry, given the forwards at that date
+template <class T>
+T swaptionPayoff(const std::vector<T>& L, const Swaption& sw, double delta)
+{
+    using std::max;
+    T discount = 1.0, annuity = 0.0;
+    for (int j = sw.expiry; j < sw.end; ++j)
+    {
+        discount = discount / (1.0 + delta * L[j]);
+        annuity = annuity + delta * discount;
+    }
+    T swapRate = (1.0 - discount) / annuity;
+    T intrinsic = swapRate - sw.strike;
+    return annuity * max(intrinsic, 0.0);
+}
+
+// Discounted portfolio value on one path: log-Euler steps of the forwards
+// under the spot measure, numeraire rolled over at every period
+template <class T, class Z>
+T pathValue(const std::vector<T>& market, const Z* z, const LmmSetup& s)
+{
+    using std::exp;
+    const int n = s.numRates;
+    const double sqrtDelta = std::sqrt(s.delta);
+
+    std::vector<T> L(n);
+    for (int i = 0; i < n; ++i)
+        L[i] = market[1 + i] + market[0];
+
+    T value = 0.0, numeraire = 1.0;
+    std::size_t next = 0;
+    for (int k = 0; k <= s.numSteps; ++k)
+    {
+        for (; next < s.swaptions.size() && s.swaptions[next].expiry == k; ++next)
+            value = value + swaptionPayoff(L, s.swaptions[next], s.delta) / numeraire;
+        if (k == s.numSteps)
+            break;
+
+        numeraire = numeraire * (1.0 + s.delta * L[k]);
+        T drift = 0.0;
+        for (int i = k + 1; i < n; ++i)
+        {
+            const T& vol = market[1 + n + i];
+            drift = drift + s.delta * vol * L[i] / (1.0 + s.delta * L[i]);
+            L[i] = L[i] * exp(vol * (drift - 0.5 * vol) * s.delta + vol * sqrtDelta * z[k]);
+        }
+    }
+    return value;
+}
+
+// =============================================================================
+// Methods
+// =============================================================================
+
+struct Result
+{
+    Result()
+        : ran(false)
+        , ms(0.0)
+        , compileMs(0.0)
+        , value(0.0)
+    {
+    }
+
+    bool ran;
+    double ms;          // mean wall-clock time per run (set by timed())
+    double compileMs;   // recording + compilation part (JIT only)
+    double value;
+    std::vector<double> sensitivities;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+const std::uint64_t kSeed = 20250101;
+
+Result runFD(const LmmSetup& s, std::size_t numPaths)
+{
+    Result r;
+    std::vector<double> z(s.numSteps);
+    auto price = [&](const std::vector<double>& market) {
+        double sum = 0.0;
+        for (std::size_t p = 0; p < numPaths; ++p)
+        {
+            pathNormals(kSeed, p, z);
+            sum += pathValue(market, z.data(), s);
+        }
+        return sum / static_cast<double>(numPaths);
+    };
+
+    r.value = price(s.market);
+    std::vector<double> bumped = s.market;
+    for (std::size_t i = 0; i < bumped.size(); ++i)
+    {
+        const double h = 1e-6 * std::max(1.0, std::fabs(s.market[i]));
+        bumped[i] = s.market[i] + h;
+        const double up = price(bumped);
+        bumped[i] = s.market[i] - h;
+        const double down = price(bumped);
+        bumped[i] = s.market[i];
+        r.sensitivities.push_back((up - down) / (2.0 * h));
+    }
+    r.ran = true;
+    return r;
+}
+
+Result runTape(const LmmSetup& s, std::size_t numPaths)
+{
+    Result r;
+    r.sensitivities.assign(s.numSensitivities(), 0.0);
+    std::vector<double> z(s.numSteps);
+
+    xad::Tape<double> tape;
+    std::vector<xad::AD> market(s.market.begin(), s.market.end());
+    for (std::size_t i = 0; i < market.size(); ++i)
+        tape.registerInput(market[i]);
+
+    double sum = 0.0;
+    for (std::size_t p = 0; p < numPaths; ++p)
+    {
+        pathNormals(kSeed, p, z);
+        tape.newRecording();
+        xad::AD v = pathValue(market, z.data(), s);
+        tape.registerOutput(v);
+        xad::derivative(v) = 1.0;
+        tape.computeAdjoints();
+
+        sum += xad::value(v);
+        for (std::size_t i = 0; i < market.size(); ++i)
+            r.sensitivities[i] += xad::derivative(market[i]);
+        tape.clearDerivatives();
+    }
+
+    r.value = sum / static_cast<double>(numPaths);
+    for (std::size_t i = 0; i < r.sensitivities.size(); ++i)
+        r.sensitivities[i] /= static_cast<double>(numPaths);
+    r.ran = true;
+    return r;
+}
+
+// Record one path with the market data and the path's normals as inputs
+xad::JITGraph recordPath(const LmmSetup& s)
+{
+    xad::JITCompiler<double, 1> jit;
+    std::vector<xad::AD> market(s.market.begin(), s.market.end());
+    std::vector<xad::AD> z(s.numSteps, xad::AD(0.0));
+    for (std::size_t i = 0; i < market.size(); ++i)
+        jit.registerInput(market[i]);
+    for (std::size_t k = 0; k < z.size(); ++k)
+        jit.registerInput(z[k]);
+    jit.newRecording();
+    xad::AD v = pathValue(market, z.data(), s);
+    jit.registerOutput(v);
+    return jit.getGraph();
+}
+
+template <class Backend>
+Result runCompiled(Backend& backend, const LmmSetup& s, std::size_t numPaths, std::size_t* graphNodes)
+{
+    Result r;
+    const Clock::time_point start = Clock::now();
+
+    const xad::JITGraph graph = recordPath(s);
+    backend.compile(graph);
+    r.compileMs = elapsedMs(start);
+    if (graphNodes)
+        *graphNodes = graph.nodeCount();
+
+    const std::size_t width = backend.vectorWidth();
+    const std::size_t numMarket = s.numSensitivities();
+    const std::size_t numInputs = numMarket + s.numSteps;
+
+    // Market data is the same on every path and stays in the buffer
+    std::vector<double> lanes(width);
+    for (std::size_t i = 0; i < numMarket; ++i)
+    {
+        std::fill(lanes.begin(), lanes.end(), s.market[i]);
+        backend.setInput(i, lanes.data());
+    }
+
+    std::vector<double> z(s.numSteps), normals(s.numSteps * width);
+    std::vector<double> outputs(width), gradients(numInputs * width);
+    r.sensitivities.assign(numMarket, 0.0);
+    double sum = 0.0;
+    for (std::size_t first = 0; first < numPaths; first += width)
+    {
+        const std::size_t active = std::min(width, numPaths - first);
+        for (std::size_t lane = 0; lane < width; ++lane)
+        {
+            pathNormals(kSeed, first + std::min(lane, active - 1), z);
+            for (int k = 0; k < s.numSteps; ++k)
+                normals[k * width + lane] = z[k];
+        }
+        for (int k = 0; k < s.numSteps; ++k)
+            backend.setInput(numMarket + k, &normals[k * width]);
+
+        backend.forwardAndBackward(outputs.data(), gradients.data());
+        for (std::size_t lane = 0; lane < active; ++lane)
+        {
+            sum += outputs[lane];
+            for (std::size_t i = 0; i < numMarket; ++i)
+                r.sensitivities[i] += gradients[i * width + lane];
+        }
+    }
+
+    r.value = sum / static_cast<double>(numPaths);
+    for (std::size_t i = 0; i < numMarket; ++i)
+        r.sensitivities[i] /= static_cast<double>(numPaths);
+    r.ran = true;
+    return r;
+}
+
+template <class Backend>
+Result runJIT(const LmmSetup& s, std::size_t numPaths, std::size_t* graphNodes)
+{
+    Backend backend;
+    return runCompiled(backend, s, numPaths, graphNodes);
+}
+
+// Scalar, so that it compares with the monolithic JIT column
+Result runSegmented(const LmmSetup& s, std::size_t numPaths, const xad::forge::SegmentationOptions& options,
+                    xad::forge::SegmentationStats* stats)
+{
+    xad::forge::SegmentedForgeBackend<double> backend(options, FORGE_INSTRUCTION_SET_SSE2_SCALAR);
+    Result r = runCompiled(backend, s, numPaths, nullptr);
+    if (stats)
+        *stats = backend.stats();
+    return r;
+}
+
+// Mean time over repetitions after warm-up runs; the sensitivities are those
+// of the last run
+template <class Run>
+Result timed(Run run, int warmup, int repetitions)
+{
+    for (int i = 0; i < warmup; ++i)
+        run();
+    Result result;
+    double totalMs = 0.0, totalCompileMs = 0.0;
+    for (int i = 0; i < repetitions; ++i)
+    {
+        const Clock::time_point start = Clock::now();
+        result = run();
+        totalMs += elapsedMs(start);
+        totalCompileMs += result.compileMs;
+    }
+    result.ms = totalMs / repetitions;
+    result.compileMs = totalCompileMs / repetitions;
+    return result;
+}
+
+// Number of sensitivities agreeing with the reference within the tolerance
+std::size_t countMatches(const Result& r, const Result& reference, double relTol, double absTol)
+{
+    std::size_t matches = 0;
+    for (std::size_t i = 0; i < reference.sensitivities.size(); ++i)
+    {
+        const double diff = std::fabs(r.sensitivities[i] - reference.sensitivities[i]);
+        if (diff <= relTol * std::fabs(reference.sensitivities[i]) + absTol)
+            ++matches;
+    }
+    return matches;
+}
+
+// =============================================================================
+// Reporting
+// =============================================================================
+
+struct Row
+{
+    std::size_t paths;
+    Result fd, tape, jit, avx, avx512, seg;
+    std::size_t fdMatches, jitMatches, avxMatches, avx512Matches, segMatches;
+};
+
+std::string cell(bool present, double ms)
+{
+    if (!present)
+        return "-";
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(2) << ms;
+    return os.str();
+}
+
+std::string jsonNumber(bool present, double v)
+{
+    if (!present)
+        return "null";
+    std::ostringstream os;
+    os << std::setprecision(17) << v;
+    return os.str();
+}
+
+std::string toJson(const LmmSetup& s, std::size_t graphNodes, const xad::forge::SegmentationStats& segStats,
+                   int warmup, int repetitions, const std::vector<Row>& rows)
+{
+    std::ostringstream os;
+    os << "{\n";
+    os << "  \"benchmark\": \"lmm_swaption\",\n";
+    os << "  \"swaptions\": " << s.swaptions.size() << ",\n";
+    os << "  \"sensitivities\": " << s.numSensitivities() << ",\n";
+    os << "  \"forward_rates\": " << s.numRates << ",\n";
+    os << "  \"time_steps\": " << s.numSteps << ",\n";
+    os << "  \"graph_nodes\": " << graphNodes << ",\n";
+    os << "  \"segments\": " << segStats.segments << ",\n";
+    os << "  \"segment_kernels\": " << segStats.kernels << ",\n";
+    os << "  \"boundary_values\": " << segStats.boundaryValues << ",\n";
+    os << "  \"avx2\": " << (xad::forge::CpuFeatures::host().avx2 ? "true" : "false") << ",\n";
+    os << "  \"avx512f\": " << (xad::forge::CpuFeatures::host().avx512f ? "true" : "false") << ",\n";
+    os << "  \"warmup\": " << warmup << ",\n";
+    os << "  \"repetitions\": " << repetitions << ",\n";
+    os << "  \"results\": [\n";
+    for (std::size_t k = 0; k < rows.size(); ++k)
+    {
+        const Row& row = rows[k];
+        os << "    {\"paths\": " << row.paths << ", \"value\": " << jsonNumber(true, row.tape.value)
+           << ", \"fd_ms\": " << jsonNumber(row.fd.ran, row.fd.ms)
+           << ", \"xad_ms\": " << jsonNumber(true, row.tape.ms)
+           << ", \"jit_ms\": " << jsonNumber(true, row.jit.ms)
+           << ", \"jit_compile_ms\": " << jsonNumber(true, row.jit.compileMs)
+           << ", \"jit_avx_ms\": " << jsonNumber(row.avx.ran, row.avx.ms)
+           << ", \"jit_avx_compile_ms\": " << jsonNumber(row.avx.ran, row.avx.compileMs)
+           << ", \"jit_avx512_ms\": " << jsonNumber(row.avx512.ran, row.avx512.ms)
+           << ", \"jit_avx512_compile_ms\": " << jsonNumber(row.avx512.ran, row.avx512.compileMs)
+           << ", \"jit_seg_ms\": " << jsonNumber(true, row.seg.ms)
+           << ", \"jit_seg_compile_ms\": " << jsonNumber(true, row.seg.compileMs)
+           << ", \"fd_matches\": " << (row.fd.ran ? std::to_string(row.fdMatches) : "null")
+           << ", \"jit_matches\": " << row.jitMatches
+           << ", \"jit_avx_matches\": " << (row.avx.ran ? std::to_string(row.avxMatches) : "null")
+           << ", \"jit_avx512_matches\": " << (row.avx512.ran ? std::to_string(row.avx512Matches) : "null")
+           << ", \"jit_seg_matches\": " << row.segMatches << "}"
+           << (k + 1 < rows.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+    return os.str();
+}
+
+std::vector<std::size_t> parseList(const char* text)
+{
+    std::vector<std::size_t> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        if (!item.empty())
+            values.push_back(static_cast<std::size_t>(std::strtoull(item.c_str(), nullptr, 10)));
+    }
+    return values;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::size_t> pathCounts = {10, 100, 1000, 10000};
+    int warmup = 2, repetitions = 3;
+    std::size_t fdMaxPaths = 1000;
+    xad::forge::SegmentationOptions segOptions;
+    segOptions.maxSegmentNodes = 2000;
+    std::string jsonFile;
+
+    for (int a = 1; a < argc; ++a)
+    {
+        const std::string arg = argv[a];
+        const bool hasValue = a + 1 < argc;
+        if (arg == "--paths" && hasValue)
+            pathCounts = parseList(argv[++a]);
+        else if (arg == "--warmup" && hasValue)
+            warmup = std::atoi(argv[++a]);
+        else if (arg == "--repetitions" && hasValue)
+            repetitions = std::max(1, std::atoi(argv[++a]));
+        else if (arg == "--fd-max-paths" && hasValue)
+            fdMaxPaths = static_cast<std::size_t>(std::strtoull(argv[++a], nullptr, 10));
+        else if (arg == "--segment-nodes" && hasValue)
+            segOptions.maxSegmentNodes = static_cast<std::size_t>(std::strtoull(argv[++a], nullptr, 10));
+        else if (arg == "--json" && hasValue)
+            jsonFile = argv[++a];
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--paths 10,100,1000] [--warmup 2] [--repetitions 3]"
+                         " [--fd-max-paths 1000] [--segment-nodes 2000] [--json results.json]\n";
+            return 2;
+        }
+    }
+
+    const LmmSetup setup = makeSetup();
+    const bool avx2 = xad::forge::CpuFeatures::host().avx2;
+    const bool avx512 = XAD_FORGE_HAS_AVX512 && xad::forge::CpuFeatures::host().avx512f;
+    std::size_t graphNodes = 0;
+    xad::forge::SegmentationStats segStats = xad::forge::SegmentationStats();
+
+    std::cout << "LMM swaption portfolio: " << setup.swaptions.size() << " swaptions, "
+              << setup.numSensitivities() << " sensitivities, " << setup.numSteps << " time steps\n";
+    if (!avx2)
+        std::cout << "AVX2 not supported by this CPU, skipping JIT-AVX\n";
+    if (!avx512)
+        std::cout << "AVX-512 not supported by this build or CPU, skipping JIT-AVX512\n";
+    std::cout << "\n" << std::setw(8) << "Paths" << std::setw(12) << "FD" << std::setw(12) << "XAD"
+              << std::setw(12) << "JIT" << std::setw(12) << "JIT-AVX" << std::setw(12) << "JIT-AVX512"
+              << std::setw(12) << "JIT-SEG" << "   (ms, JIT incl. compile)\n";
+
+    std::vector<Row> rows;
+    bool allMatch = true;
+    for (std::size_t paths : pathCounts)
+    {
+        if (paths == 0)
+            continue;
+        Row row;
+        row.paths = paths;
+        row.tape = timed([&]() { return runTape(setup, paths); }, warmup, repetitions);
+        row.jit = timed([&]() { return runJIT<xad::forge::ForgeBackend<double>>(setup, paths, &graphNodes); },
+                        warmup, repetitions);
+        if (avx2)
+            row.avx = timed([&]() { return runJIT<xad::forge::ForgeBackendAVX<double>>(setup, paths, nullptr); },
+                            warmup, repetitions);
+#if XAD_FORGE_HAS_AVX512
+        if (avx512)
+            row.avx512 = timed(
+                [&]() { return runJIT<xad::forge::ForgeBackendAVX512<double>>(setup, paths, nullptr); }, warmup,
+                repetitions);
+#endif
+        row.seg = timed([&]() { return runSegmented(setup, paths, segOptions, &segStats); }, warmup, repetitions);
+        if (paths <= fdMaxPaths)
+            row.fd = timed([&]() { return runFD(setup, paths); }, 0, 1);
+
+        // JIT must reproduce the tape up to rounding; FD only to its truncation error
+        row.jitMatches = countMatches(row.jit, row.tape, 1e-9, 1e-12);
+        row.avxMatches = row.avx.ran ? countMatches(row.avx, row.tape, 1e-9, 1e-12) : 0;
+        row.avx512Matches = row.avx512.ran ? countMatches(row.avx512, row.tape, 1e-9, 1e-12) : 0;
+        row.segMatches = countMatches(row.seg, row.tape, 1e-9, 1e-12);
+        row.fdMatches = row.fd.ran ? countMatches(row.fd, row.tape, 1e-4, 1e-7) : 0;
+        const std::size_t n = setup.numSensitivities();
+        allMatch = allMatch && row.jitMatches == n && (!row.avx.ran || row.avxMatches == n) &&
+                   (!row.avx512.ran || row.avx512Matches == n) && row.segMatches == n &&
+                   (!row.fd.ran || row.fdMatches == n);
+
+        std::cout << std::setw(8) << paths << std::setw(12) << cell(row.fd.ran, row.fd.ms) << std::setw(12)
+                  << cell(true, row.tape.ms) << std::setw(12) << cell(true, row.jit.ms) << std::setw(12)
+                  << cell(row.avx.ran, row.avx.ms) << std::setw(12) << cell(row.avx512.ran, row.avx512.ms)
+                  << std::setw(12) << cell(true, row.seg.ms);
+        std::cout << "   matches vs XAD: JIT " << row.jitMatches << "/" << n;
+        if (row.avx.ran)
+            std::cout << ", JIT-AVX " << row.avxMatches << "/" << n;
+        if (row.avx512.ran)
+            std::cout << ", JIT-AVX512 " << row.avx512Matches << "/" << n;
+        std::cout << ", JIT-SEG " << row.segMatches << "/" << n;
+        if (row.fd.ran)
+            std::cout << ", FD " << row.fdMatches << "/" << n;
+        std::cout << "\n";
+        rows.push_back(row);
+    }
+
+    // Segmented vs. monolithic, both scalar: the segmented kernels compile
+    // smaller graphs but pay per segment on every evaluation
+    std::cout << "\nSegmented vs. monolithic (scalar): " << segStats.segments << " segments, " << segStats.kernels
+              << " kernels, " << segStats.boundaryValues << " boundary values\n";
+    std::cout << std::setw(8) << "Paths" << std::setw(14) << "JIT compile" << std::setw(14) << "JIT eval"
+              << std::setw(14) << "SEG compile" << std::setw(14) << "SEG eval" << "   (ms)\n";
+    for (std::size_t k = 0; k < rows.size(); ++k)
+    {
+        const Row& row = rows[k];
+        std::cout << std::setw(8) << row.paths << std::setw(14) << cell(true, row.jit.compileMs) << std::setw(14)
+                  << cell(true, row.jit.ms - row.jit.compileMs) << std::setw(14) << cell(true, row.seg.compileMs)
+                  << std::setw(14) << cell(true, row.seg.ms - row.seg.compileMs) << "\n";
+    }
+
+    const std::string json = toJson(setup, graphNodes, segStats, warmup, repetitions, rows);
+    if (jsonFile.empty())
+    {
+        std::cout << "\n" << json;
+    }
+    else
+    {
+        std::ofstream out(jsonFile.c_str());
+        out << json;
+        std::cout << "\nResults written to " << jsonFile << "\n";
+    }
+
+    if (!allMatch)
+    {
+        std::cerr << "Sensitivity cross-check failed\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,299 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  AsyncForgeBackend - Background Forge compilation with interpreter fallback
+//
+//  This file is part of xad-forge, providing Forge JIT compilation
+//  as a backend for XAD automatic differentiation.
+//
+//  compile() returns immediately and compiles the graph with Forge on a
+//  background thread. Until that finishes, evaluations run through XAD's
+//  graph interpreter; afterwards they switch to the compiled kernel. This
+//  removes the compile latency from the first evaluations, at the cost of
+//  running those on the (slower) interpreter.
+//
+//  Copyright (c) 2025 The xad-forge Authors
+//  https://github.com/da-roth/xad-forge
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <XAD/JITBackendInterface.hpp>
+#include <XAD/JITGraph.hpp>
+#include <XAD/JITGraphInterpreter.hpp>
+
+#include <xad-forge/ForgeBackend.hpp>
+#include <xad-forge/KernelCache.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace xad
+{
+namespace forge
+{
+
+/**
+ * Asynchronously compiling Backend - implements xad::JITBackend interface.
+ *
+ * Backend is the Forge backend compiled in the background (ForgeBackend,
+ * ForgeBackendAVX, ForgeBackendAuto, ...); its vector width is used from the
+ * start. While it compiles, each lane is evaluated by an
+ * xad::JITGraphInterpreter, so results are the same before and after the
+ * switch up to floating-point rounding.
+ *
+ * If background compilation fails, evaluation stays on the interpreter and
+ * wait() rethrows the error.
+ *
+ * Usage pattern (via JITCompiler):
+ *   xad::JITCompiler<double> jit;
+ *   // ... record graph ...
+ *   jit.setBackend(std::make_unique<xad::forge::AsyncForgeBackend<double>>());
+ *   jit.compile();                          // returns immediately
+ *   jit.forwardAndBackward(&out, &grad);    // interpreter or Forge, whichever is ready
+ */
+template <class Scalar, class Backend = ForgeBackend<Scalar>>
+class AsyncForgeBackend : public xad::JITBackend<Scalar>
+{
+    static_assert(std::is_same<Scalar, double>::value,
+                  "AsyncForgeBackend only supports double precision. Forge does not currently support float.");
+
+  public:
+    explicit AsyncForgeBackend(bool useGraphOptimizations = false)
+        : useOptimizations_(useGraphOptimizations)
+        , cache_(nullptr)
+        , width_(Backend(useGraphOptimizations).vectorWidth())
+        , ready_(false)
+    {
+    }
+
+    ~AsyncForgeBackend() override
+    {
+        join();
+    }
+
+    // No copy or move (a background thread refers to this object)
+    AsyncForgeBackend(const AsyncForgeBackend&) = delete;
+    AsyncForgeBackend& operator=(const AsyncForgeBackend&) = delete;
+
+    //=========================================================================
+    // JITBackend interface implementation
+    //=========================================================================
+
+    /**
+     * Start compiling in the background and return immediately.
+     * The graph is copied, so the caller may record a new one meanwhile.
+     */
+    void compile(const xad::JITGraph& jitGraph) override
+    {
+        reset();
+
+        graph_.reset(new xad::JITGraph(jitGraph));
+        interpreter_.compile(*graph_);
+        inputs_.assign(graph_->input_ids.size() * width_, Scalar(0));
+
+        thread_ = std::thread([this]() {
+            try
+            {
+                std::unique_ptr<Backend> backend(new Backend(useOptimizations_));
+                backend->setKernelCache(cache_);
+                backend->compile(*graph_);
+                pending_ = std::move(backend);
+            }
+            catch (...)
+            {
+                error_ = std::current_exception();
+            }
+            ready_.store(true, std::memory_order_release);
+        });
+    }
+
+    /**
+     * Wait for any background compilation and discard all state.
+     */
+    void reset() override
+    {
+        join();
+        active_.reset();
+        pending_.reset();
+        error_ = std::exception_ptr();
+        ready_.store(false, std::memory_order_relaxed);
+        interpreter_.reset();
+        graph_.reset();
+        inputs_.clear();
+    }
+
+    std::size_t vectorWidth() const override { return width_; }
+    std::size_t numInputs() const override { return graph_ ? graph_->input_ids.size() : 0; }
+    std::size_t numOutputs() const override { return graph_ ? graph_->output_ids.size() : 0; }
+
+    /**
+     * Set vectorWidth() values for an input (one per parallel evaluation).
+     */
+    void setInput(std::size_t inputIndex, const Scalar* values) override
+    {
+        if (inputIndex >= numInputs())
+            throw std::runtime_error("Input index out of range");
+        std::copy(values, values + width_, inputs_.begin() + inputIndex * width_);
+        if (switchIfReady())
+            active_->setInput(inputIndex, values);
+    }
+
+    void forward(Scalar* outputs) override
+    {
+        if (!graph_)
+            throw std::runtime_error("Backend not compiled");
+        if (switchIfReady())
+        {
+            active_->forward(outputs);
+            return;
+        }
+        interpret(outputs, nullptr);
+    }
+
+    void forwardAndBackward(Scalar* outputs, Scalar* inputGradients) override
+    {
+        if (!graph_)
+            throw std::runtime_error("Backend not compiled");
+        if (switchIfReady())
+        {
+            active_->forwardAndBackward(outputs, inputGradients);
+            return;
+        }
+        interpret(outputs, inputGradients);
+    }
+
+    // =========================================================================
+    // Async control
+    // =========================================================================
+
+    /**
+     * Whether evaluations run on the compiled Forge kernel.
+     */
+    bool isCompiled()
+    {
+        return switchIfReady();
+    }
+
+    /**
+     * Block until background compilation has finished; afterwards evaluations
+     * run on the compiled kernel. Rethrows a compilation error.
+     */
+    void wait()
+    {
+        join();
+        switchIfReady();
+        if (error_)
+            std::rethrow_exception(error_);
+    }
+
+    /**
+     * Compile through a kernel cache (see Backend::setKernelCache()).
+     * Takes effect for the next compile().
+     */
+    void setKernelCache(KernelCache* cache) { cache_ = cache; }
+
+    /**
+     * The compiled backend, or null while still compiling.
+     */
+    Backend* compiledBackend() { return switchIfReady() ? active_.get() : nullptr; }
+
+  private:
+    // Adopt the background result once it is available. Returns whether the
+    // compiled backend is active.
+    bool switchIfReady()
+    {
+        if (active_)
+            return true;
+        if (!ready_.load(std::memory_order_acquire))
+            return false;
+
+        join();
+        if (!pending_)
+            return false;  // compilation failed, stay on the interpreter
+
+        active_ = std::move(pending_);
+        for (std::size_t i = 0; i < numInputs(); ++i)
+            active_->setInput(i, &inputs_[i * width_]);
+        return true;
+    }
+
+    // Evaluate each lane with the interpreter; same layout as the Forge backends
+    void interpret(Scalar* outputs, Scalar* inputGradients)
+    {
+        const std::size_t nIn = numInputs();
+        const std::size_t nOut = numOutputs();
+        laneOutputs_.resize(nOut);
+        laneGradients_.resize(nIn);
+
+        for (std::size_t lane = 0; lane < width_; ++lane)
+        {
+            for (std::size_t i = 0; i < nIn; ++i)
+                interpreter_.setInput(i, &inputs_[i * width_ + lane]);
+
+            if (inputGradients)
+                interpreter_.forwardAndBackward(laneOutputs_.data(), laneGradients_.data());
+            else
+                interpreter_.forward(laneOutputs_.data());
+
+            for (std::size_t o = 0; o < nOut; ++o)
+                outputs[o * width_ + lane] = laneOutputs_[o];
+            if (inputGradients)
+            {
+                for (std::size_t i = 0; i < nIn; ++i)
+                    inputGradients[i * width_ + lane] = laneGradients_[i];
+            }
+        }
+    }
+
+    void join()
+    {
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    bool useOptimizations_;
+    KernelCache* cache_;  // not owned, may be null
+    std::size_t width_;
+
+    std::unique_ptr<xad::JITGraph> graph_;  // copy, outlives the background compile
+    xad::JITGraphInterpreter<Scalar> interpreter_;
+    std::vector<Scalar> inputs_;            // current inputs, input-major with width_ lanes
+    std::vector<Scalar> laneOutputs_;
+    std::vector<Scalar> laneGradients_;
+
+    // Written by the background thread before ready_ is set
+    std::thread thread_;
+    std::atomic<bool> ready_;
+    std::unique_ptr<Backend> pending_;
+    std::exception_ptr error_;
+
+    std::unique_ptr<Backend> active_;
+};
+
+}  // namespace forge
+}  // namespace xad
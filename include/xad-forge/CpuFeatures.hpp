@@ -0,0 +1,168 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  CpuFeatures - Runtime detection of the host's SIMD instruction sets
+//
+//  This file is part of xad-forge, providing Forge JIT compilation
+//  as a backend for XAD automatic differentiation.
+//
+//  Forge generates machine code at runtime, so the instruction set to
+//  compile for should be chosen from the CPU the process runs on, not from
+//  the flags the application was built with. The checks use CPUID and also
+//  verify via XGETBV that the OS saves the wider register state.
+//
+//  Copyright (c) 2025 The xad-forge Authors
+//  https://github.com/da-roth/xad-forge
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <xad-forge/ForgeKernel.hpp>
+
+// Forge C API - stable ABI
+#include <forge_c_api.h>
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define XAD_FORGE_X86_CPUID 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define XAD_FORGE_X86_CPUID 1
+#else
+#define XAD_FORGE_X86_CPUID 0
+#endif
+
+namespace xad
+{
+namespace forge
+{
+
+/**
+ * SIMD capabilities of the host CPU (and OS), detected once per process.
+ */
+struct CpuFeatures
+{
+    bool avx2;     ///< AVX2 + FMA with YMM state enabled by the OS
+    bool avx512f;  ///< AVX-512F with ZMM/opmask state enabled by the OS
+
+    /// Features of the CPU this process is running on
+    static const CpuFeatures& host()
+    {
+        static const CpuFeatures features = detect();
+        return features;
+    }
+
+  private:
+    static CpuFeatures detect()
+    {
+        CpuFeatures f;
+        f.avx2 = false;
+        f.avx512f = false;
+
+#if XAD_FORGE_X86_CPUID
+        uint32_t regs[4];
+        cpuid(0, 0, regs);
+        const uint32_t maxLeaf = regs[0];
+        if (maxLeaf < 7)
+            return f;
+
+        cpuid(1, 0, regs);
+        const bool osxsave = (regs[2] & (1u << 27)) != 0;
+        const bool avx = (regs[2] & (1u << 28)) != 0;
+        const bool fma = (regs[2] & (1u << 12)) != 0;
+        if (!osxsave || !avx)
+            return f;
+
+        // XCR0: bits 1-2 = SSE/AVX state, bits 5-7 = AVX-512 opmask/ZMM state
+        const uint64_t xcr0 = xgetbv0();
+        const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+        const bool zmmEnabled = (xcr0 & 0xE6) == 0xE6;
+
+        cpuid(7, 0, regs);
+        f.avx2 = ymmEnabled && fma && (regs[1] & (1u << 5)) != 0;
+        f.avx512f = zmmEnabled && f.avx2 && (regs[1] & (1u << 16)) != 0;
+#endif
+        return f;
+    }
+
+#if XAD_FORGE_X86_CPUID
+    static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* regs)
+    {
+#if defined(_MSC_VER)
+        int r[4];
+        __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i)
+            regs[i] = static_cast<uint32_t>(r[i]);
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    static uint64_t xgetbv0()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        // Encoded directly so no -mxsave is needed to compile this
+        uint32_t lo, hi;
+        __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(lo), "=d"(hi) : "c"(0));
+        return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+    }
+#endif
+};
+
+/**
+ * Widest Forge instruction set that both this build and the host CPU support.
+ */
+inline ForgeInstructionSet bestInstructionSet()
+{
+    const CpuFeatures& cpu = CpuFeatures::host();
+#if XAD_FORGE_HAS_AVX512
+    if (cpu.avx512f)
+        return FORGE_INSTRUCTION_SET_AVX512_PACKED;
+#endif
+    if (cpu.avx2)
+        return FORGE_INSTRUCTION_SET_AVX2_PACKED;
+    return FORGE_INSTRUCTION_SET_SSE2_SCALAR;
+}
+
+/**
+ * Whether kernels for an instruction set can run on the host CPU.
+ */
+inline bool hostSupports(ForgeInstructionSet instructionSet)
+{
+    const CpuFeatures& cpu = CpuFeatures::host();
+    switch (instructionSet)
+    {
+        case FORGE_INSTRUCTION_SET_AVX2_PACKED:
+            return cpu.avx2;
+#if XAD_FORGE_HAS_AVX512
+        case FORGE_INSTRUCTION_SET_AVX512_PACKED:
+            return cpu.avx512f;
+#endif
+        default:
+            return true;
+    }
+}
+
+}  // namespace forge
+}  // namespace xad
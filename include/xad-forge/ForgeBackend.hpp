@@ -2,14 +2,21 @@
 
 //////////////////////////////////////////////////////////////////////////////
 //
-//  ForgeBackend - Scalar backend using Forge C API
+//  ForgeBackend - Backends using Forge C API
 //
 //  This file is part of xad-forge, providing Forge JIT compilation
 //  as a backend for XAD automatic differentiation.
 //
-//  This backend processes one evaluation per kernel execution using SSE2
-//  scalar instructions. For backends that support multiple parallel
-//  evaluations per execution (e.g., ForgeBackendAVX), see ForgeBackendAVX.hpp.
+//  BasicForgeBackend compiles for one Forge instruction set. ForgeBackend
+//  processes one evaluation per kernel execution using SSE2 scalar
+//  instructions; for multiple parallel evaluations per execution see
+//  ForgeBackendAVX.hpp and ForgeBackendAVX512.hpp, which use the same class
+//  with a wider instruction set, and ForgeBackendAuto.hpp, which chooses the
+//  instruction set at runtime.
+//
+//  The compiled kernel is held in a shared ForgeKernel (see ForgeKernel.hpp),
+//  so several backends - e.g. one per thread - can run the same compiled code,
+//  each with its own execution buffer.
 //
 //  Uses the stable C API for binary compatibility across compilers.
 //
@@ -37,15 +44,21 @@
 #include <XAD/JITBackendInterface.hpp>
 #include <XAD/JITGraph.hpp>
 
+#include <xad-forge/CpuFeatures.hpp>
+#include <xad-forge/ForgeKernel.hpp>
+#include <xad-forge/GraphOptimizer.hpp>
+#include <xad-forge/KernelCache.hpp>
+
 // Forge C API - stable ABI
 #include <forge_c_api.h>
 
 #include <cstddef>
 #include <cstdint>
-#include <cstring>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace xad
@@ -53,241 +66,196 @@ namespace xad
 namespace forge
 {
 
+/// BasicForgeBackend instruction set argument selecting the instruction set at runtime
+constexpr int RUNTIME_INSTRUCTION_SET = -1;
+
 /**
- * Scalar Backend using Forge C API - implements xad::JITBackend interface.
+ * Backend using Forge C API - implements xad::JITBackend interface.
  *
  * Uses the stable C API for binary compatibility with precompiled Forge packages.
- * Processes one evaluation per kernel execution using SSE2 scalar instructions.
+ * InstructionSet (a ForgeInstructionSet) fixes the generated code and with it
+ * VECTOR_WIDTH, the number of parallel evaluations per kernel execution:
+ * 1 for SSE2 scalar, 4 for AVX2, 8 for AVX-512. With RUNTIME_INSTRUCTION_SET
+ * the instruction set is fixed at construction instead (bestInstructionSet()
+ * by default) and VECTOR_WIDTH is 0; vectorWidth() reports the width in use
+ * either way. Use the aliases ForgeBackend, ForgeBackendAVX
+ * (ForgeBackendAVX.hpp), ForgeBackendAVX512 (ForgeBackendAVX512.hpp) and
+ * ForgeBackendAuto (ForgeBackendAuto.hpp) rather than this template directly.
+ *
+ * All per-lane arrays are laid out value-major: input, output or gradient i
+ * of lane l is at index i * vectorWidth() + l.
  *
  * Note: Forge currently only supports double precision. This backend is templated
  * to match the JITBackend<Scalar> interface, but only Scalar=double is supported.
  * Using Scalar=float will result in a static_assert failure.
  *
- * Usage pattern (via JITCompiler):
- *   xad::JITCompiler<double> jit;
- *   // ... record graph ...
- *   jit.setBackend(std::make_unique<xad::forge::ForgeBackend<double>>());
- *   jit.compile();
- *   jit.setInput(0, &inputValue);
- *   double output, gradient;
- *   jit.forwardAndBackward(&output, &gradient);
+ * Sharing one compiled kernel across threads:
+ *   xad::forge::ForgeBackendAVX<double> master;
+ *   master.compile(graph);
+ *   // in each worker thread:
+ *   xad::forge::ForgeBackendAVX<double> worker(master.kernel());
+ *   worker.setConstants(master.constants());  // if master changed runtime constants
  */
-template <class Scalar>
-class ForgeBackend : public xad::JITBackend<Scalar>
+template <class Scalar, int InstructionSet>
+class BasicForgeBackend : public xad::JITBackend<Scalar>
 {
     static_assert(std::is_same<Scalar, double>::value,
                   "ForgeBackend only supports double precision. Forge does not currently support float.");
 
   public:
-    explicit ForgeBackend(bool useGraphOptimizations = false)
-        : useOptimizations_(useGraphOptimizations)
-        , graph_(nullptr)
-        , config_(nullptr)
-        , kernel_(nullptr)
-        , buffer_(nullptr)
+    /// Number of parallel evaluations per kernel execution (0 if chosen at runtime)
+    static constexpr int VECTOR_WIDTH = InstructionSet == RUNTIME_INSTRUCTION_SET             ? 0
+                                        : InstructionSet == FORGE_INSTRUCTION_SET_SSE2_SCALAR ? 1
+                                        : InstructionSet == FORGE_INSTRUCTION_SET_AVX2_PACKED ? 4
+                                                                                              : 8;
+
+    /**
+     * Use this backend's instruction set, or with RUNTIME_INSTRUCTION_SET the
+     * widest one supported by the host CPU.
+     */
+    explicit BasicForgeBackend(bool useGraphOptimizations = false)
+        : instructionSet_(InstructionSet == RUNTIME_INSTRUCTION_SET ? bestInstructionSet()
+                                                                    : static_cast<ForgeInstructionSet>(InstructionSet))
+        , useOptimizations_(useGraphOptimizations)
+        , cache_(nullptr)
+        , prepass_(false)
+        , compact_(false)
     {
     }
 
-    ~ForgeBackend() override
+    /**
+     * Use a specific instruction set, e.g. to cap the vector width of a
+     * runtime-dispatched backend. Throws std::invalid_argument if the host CPU
+     * does not support it or it differs from a fixed InstructionSet.
+     */
+    explicit BasicForgeBackend(ForgeInstructionSet instructionSet, bool useGraphOptimizations = false)
+        : instructionSet_(instructionSet)
+        , useOptimizations_(useGraphOptimizations)
+        , cache_(nullptr)
+        , prepass_(false)
+        , compact_(false)
     {
-        cleanup();
+        if (InstructionSet != RUNTIME_INSTRUCTION_SET && instructionSet != InstructionSet)
+            throw std::invalid_argument(std::string("ForgeBackend: this backend compiles ") +
+                                        instructionSetName(static_cast<ForgeInstructionSet>(InstructionSet)) +
+                                        " code only");
+        if (!hostSupports(instructionSet))
+            throw std::invalid_argument("ForgeBackend: instruction set not supported by this CPU");
     }
 
-    ForgeBackend(ForgeBackend&& other) noexcept
-        : useOptimizations_(other.useOptimizations_)
-        , graph_(other.graph_)
-        , config_(other.config_)
-        , kernel_(other.kernel_)
-        , buffer_(other.buffer_)
-        , inputIds_(std::move(other.inputIds_))
-        , outputIds_(std::move(other.outputIds_))
+    /**
+     * Attach to an already compiled kernel, which must target this backend's
+     * instruction set unless it is RUNTIME_INSTRUCTION_SET.
+     * Only a new execution buffer is created; nothing is recompiled. Runtime
+     * constants start at the kernel's recorded values; see constants().
+     */
+    explicit BasicForgeBackend(std::shared_ptr<const ForgeKernel> kernel)
+        : instructionSet_(FORGE_INSTRUCTION_SET_SSE2_SCALAR)
+        , useOptimizations_(false)
+        , cache_(nullptr)
+        , prepass_(false)
+        , compact_(false)
     {
-        other.graph_ = nullptr;
-        other.config_ = nullptr;
-        other.kernel_ = nullptr;
-        other.buffer_ = nullptr;
+        attach(std::move(kernel));
     }
 
-    ForgeBackend& operator=(ForgeBackend&& other) noexcept
+    ~BasicForgeBackend() override {}
+
+    BasicForgeBackend(BasicForgeBackend&& other) noexcept
+        : instructionSet_(other.instructionSet_)
+        , useOptimizations_(other.useOptimizations_)
+        , cache_(other.cache_)
+        , runtimeConstants_(std::move(other.runtimeConstants_))
+        , prepass_(other.prepass_)
+        , prepassStats_(other.prepassStats_)
+        , compact_(other.compact_)
+        , kernel_(std::move(other.kernel_))
+        , buffer_(std::move(other.buffer_))
+    {
+    }
+
+    BasicForgeBackend& operator=(BasicForgeBackend&& other) noexcept
     {
         if (this != &other)
         {
-            cleanup();
+            instructionSet_ = other.instructionSet_;
             useOptimizations_ = other.useOptimizations_;
-            graph_ = other.graph_;
-            config_ = other.config_;
-            kernel_ = other.kernel_;
-            buffer_ = other.buffer_;
-            inputIds_ = std::move(other.inputIds_);
-            outputIds_ = std::move(other.outputIds_);
-            other.graph_ = nullptr;
-            other.config_ = nullptr;
-            other.kernel_ = nullptr;
-            other.buffer_ = nullptr;
+            cache_ = other.cache_;
+            runtimeConstants_ = std::move(other.runtimeConstants_);
+            prepass_ = other.prepass_;
+            prepassStats_ = other.prepassStats_;
+            compact_ = other.compact_;
+            kernel_ = std::move(other.kernel_);
+            buffer_ = std::move(other.buffer_);
         }
         return *this;
     }
 
     // No copy
-    ForgeBackend(const ForgeBackend&) = delete;
-    ForgeBackend& operator=(const ForgeBackend&) = delete;
+    BasicForgeBackend(const BasicForgeBackend&) = delete;
+    BasicForgeBackend& operator=(const BasicForgeBackend&) = delete;
 
     //=========================================================================
     // JITBackend interface implementation
     //=========================================================================
 
     /**
-     * Compile an xad::JITGraph with SSE2 scalar instruction set.
+     * Compile an xad::JITGraph for this backend's instruction set.
      */
     void compile(const xad::JITGraph& jitGraph) override
     {
-        cleanup();
-
-        // Create graph
-        graph_ = forge_graph_create();
-        if (!graph_)
-            throw std::runtime_error(std::string("Forge graph creation failed: ") + forge_get_last_error());
-
-        // Pre-populate forge's constPool to match XAD's const_pool indices.
-        std::vector<uint32_t> constNodeIds;
-        constNodeIds.reserve(jitGraph.const_pool.size());
-        for (std::size_t i = 0; i < jitGraph.const_pool.size(); ++i)
+        reset();
+        if (prepass_)
         {
-            uint32_t nodeId = forge_graph_add_constant(graph_, jitGraph.const_pool[i]);
-            if (nodeId == UINT32_MAX)
-                throw std::runtime_error(std::string("Forge add_constant failed: ") + forge_get_last_error());
-            constNodeIds.push_back(nodeId);
+            GraphOptimizationOptions options;
+            options.runtimeConstants = runtimeConstants_;
+            compileGraph(GraphOptimizer::optimize(jitGraph, options, &prepassStats_));
         }
-
-        // Add graph nodes
-        inputIds_.clear();
-        std::vector<uint32_t> nodeIdMap(jitGraph.nodeCount());
-
-        for (std::size_t i = 0; i < jitGraph.nodeCount(); ++i)
-        {
-            ForgeOpCode op = static_cast<ForgeOpCode>(jitGraph.nodes[i].op);
-            uint32_t nodeId;
-
-            if (op == FORGE_OP_INPUT)
-            {
-                nodeId = forge_graph_add_input(graph_);
-                if (nodeId == UINT32_MAX)
-                    throw std::runtime_error(std::string("Forge add_input failed: ") + forge_get_last_error());
-                inputIds_.push_back(nodeId);
-            }
-            else if (op == FORGE_OP_CONSTANT)
-            {
-                uint32_t constIndex = static_cast<uint32_t>(jitGraph.nodes[i].imm);
-                if (constIndex >= constNodeIds.size())
-                    throw std::runtime_error("Invalid constant pool index in JITGraph");
-                nodeId = constNodeIds[constIndex];
-            }
-            else
-            {
-                uint32_t a = jitGraph.nodes[i].a;
-                uint32_t b = jitGraph.nodes[i].b;
-                uint32_t c = jitGraph.nodes[i].c;
-
-                if (a < i) a = nodeIdMap[a];
-                if (b < i) b = nodeIdMap[b];
-                if (c < i) c = nodeIdMap[c];
-
-                double imm = jitGraph.nodes[i].imm;
-                int isActive = (jitGraph.nodes[i].flags & xad::JITNodeFlags::IsActive) != 0 ? 1 : 0;
-
-                nodeId = forge_graph_add_node(graph_, op, a, b, c, imm, isActive, 0);
-                if (nodeId == UINT32_MAX)
-                    throw std::runtime_error(std::string("Forge add_node failed: ") + forge_get_last_error());
-            }
-
-            nodeIdMap[i] = nodeId;
-        }
-
-        // Mark outputs
-        outputIds_.clear();
-        for (auto xadOutputId : jitGraph.output_ids)
+        else
         {
-            uint32_t forgeOutputId = nodeIdMap[xadOutputId];
-            outputIds_.push_back(forgeOutputId);
-            ForgeError err = forge_graph_mark_output(graph_, forgeOutputId);
-            if (err != FORGE_SUCCESS)
-                throw std::runtime_error(std::string("Forge mark_output failed: ") + forge_get_last_error());
+            prepassStats_ = GraphOptimizationStats();
+            compileGraph(jitGraph);
         }
-
-        // Mark diff inputs
-        for (auto xadInputId : jitGraph.input_ids)
-        {
-            uint32_t forgeInputId = nodeIdMap[xadInputId];
-            ForgeError err = forge_graph_mark_diff_input(graph_, forgeInputId);
-            if (err != FORGE_SUCCESS)
-                throw std::runtime_error(std::string("Forge mark_diff_input failed: ") + forge_get_last_error());
-        }
-
-        // Propagate needsGradient flags
-        {
-            ForgeError err = forge_graph_propagate_gradients(graph_);
-            if (err != FORGE_SUCCESS)
-                throw std::runtime_error(std::string("Forge propagate_gradients failed: ") + forge_get_last_error());
-        }
-
-        // Create config with SSE2 scalar
-        config_ = useOptimizations_ ? forge_config_create_fast() : forge_config_create_default();
-        if (!config_)
-            throw std::runtime_error("Forge config creation failed");
-
-        forge_config_set_instruction_set(config_, FORGE_INSTRUCTION_SET_SSE2_SCALAR);
-
-        // Compile
-        kernel_ = forge_compile(graph_, config_);
-        if (!kernel_)
-            throw std::runtime_error(std::string("Forge compilation failed: ") + forge_get_last_error());
-
-        // Create buffer
-        buffer_ = forge_buffer_create(graph_, kernel_);
-        if (!buffer_)
-            throw std::runtime_error(std::string("Forge buffer creation failed: ") + forge_get_last_error());
     }
 
     void reset() override
     {
-        cleanup();
-        inputIds_.clear();
-        outputIds_.clear();
+        buffer_ = ForgeBuffer();
+        kernel_.reset();
     }
 
-    std::size_t vectorWidth() const override { return 1; }
-    std::size_t numInputs() const override { return inputIds_.size(); }
-    std::size_t numOutputs() const override { return outputIds_.size(); }
+    std::size_t vectorWidth() const override { return ForgeKernel::vectorWidthFor(instructionSet_); }
+    std::size_t numInputs() const override { return kernel_ ? kernel_->numInputs() : 0; }
+    std::size_t numOutputs() const override { return kernel_ ? kernel_->numOutputs() : 0; }
 
     /**
-     * Set value for an input.
+     * Set vectorWidth() values for an input (one per parallel evaluation).
      */
     void setInput(std::size_t inputIndex, const Scalar* values) override
     {
-        if (inputIndex >= inputIds_.size())
-            throw std::runtime_error("Input index out of range");
-        forge_buffer_set_lanes(buffer_, inputIds_[inputIndex], values);
+        buffer_.setInput(inputIndex, values);
+    }
+
+    /**
+     * Set all inputs in one call: values[i * vectorWidth() + lane] is input i,
+     * the same layout as the gradients of forwardAndBackward().
+     */
+    void setInputs(const Scalar* values)
+    {
+        buffer_.setInputs(values);
     }
 
     /**
      * Execute forward pass only.
+     *
+     * Runs the forward-only kernel, which has no adjoint sweep, so there are
+     * no gradients to clear.
      */
     void forward(Scalar* outputs) override
     {
-        if (!kernel_ || !buffer_)
+        if (!buffer_.valid())
             throw std::runtime_error("Backend not compiled");
-
-        // Clear gradients and execute (Forge always does forward+backward)
-        forge_buffer_clear_gradients(buffer_);
-        ForgeError err = forge_execute(kernel_, buffer_);
-        if (err != FORGE_SUCCESS)
-            throw std::runtime_error(std::string("Forge execution failed: ") + forge_get_last_error());
-
-        // Get outputs
-        for (std::size_t i = 0; i < outputIds_.size(); ++i)
-        {
-            forge_buffer_get_lanes(buffer_, outputIds_[i], outputs + i);
-        }
+        buffer_.forward(outputs);
     }
 
     /**
@@ -295,65 +263,275 @@ class ForgeBackend : public xad::JITBackend<Scalar>
      */
     void forwardAndBackward(Scalar* outputs, Scalar* inputGradients) override
     {
-        if (!kernel_ || !buffer_)
+        if (!buffer_.valid())
             throw std::runtime_error("Backend not compiled");
+        buffer_.forwardAndBackward(outputs, inputGradients);
+    }
 
-        // Clear gradients and execute
-        forge_buffer_clear_gradients(buffer_);
-        ForgeError err = forge_execute(kernel_, buffer_);
-        if (err != FORGE_SUCCESS)
-            throw std::runtime_error(std::string("Forge execution failed: ") + forge_get_last_error());
+    /**
+     * Execute forward + backward seeded with the given output adjoints
+     * (outputAdjoints[k * vectorWidth() + lane]), so inputGradients holds the
+     * adjoint-weighted sum of the output gradients. See ForgeBuffer.
+     */
+    void forwardAndBackward(Scalar* outputs, const Scalar* outputAdjoints, Scalar* inputGradients)
+    {
+        if (!buffer_.valid())
+            throw std::runtime_error("Backend not compiled");
+        buffer_.forwardAndBackward(outputs, outputAdjoints, inputGradients);
+    }
 
-        // Get outputs
-        for (std::size_t i = 0; i < outputIds_.size(); ++i)
-        {
-            forge_buffer_get_lanes(buffer_, outputIds_[i], outputs + i);
-        }
+    // =========================================================================
+    // Bulk evaluation
+    // =========================================================================
 
-        // Get input gradients
-        for (std::size_t i = 0; i < inputIds_.size(); ++i)
-        {
-            forge_buffer_get_gradient_lanes(buffer_, &inputIds_[i], 1, inputGradients + i);
-        }
+    /**
+     * Evaluate numPaths independent paths in one call.
+     *
+     * All arrays are structure-of-arrays, i.e. the value of input i for path p
+     * is inputsSoA[i * numPaths + p], and likewise for outputsSoA (numOutputs()
+     * rows) and gradientsSoA (numInputs() rows). Paths are processed in batches
+     * of vectorWidth(); numPaths need not be a multiple of it. In the final
+     * partial batch the unused lanes repeat the last path and their results are
+     * discarded.
+     *
+     * If gradientsSoA is null, only the forward-only kernel is run.
+     * This overwrites any input values previously set with setInput().
+     */
+    void evaluate(std::size_t numPaths, const Scalar* inputsSoA, Scalar* outputsSoA,
+                  Scalar* gradientsSoA = nullptr)
+    {
+        if (!buffer_.valid())
+            throw std::runtime_error("Backend not compiled");
+        buffer_.evaluate(numPaths, inputsSoA, outputsSoA, gradientsSoA);
     }
 
+    // =========================================================================
+    // Gradient accumulation
+    // =========================================================================
+
+    /**
+     * Execute forward + backward for all vectorWidth() lanes and add the outputs and
+     * input gradients to running sums instead of returning them. Read the
+     * totals with getAccumulatedOutputs() / getAccumulatedGradients().
+     */
+    void forwardAndAccumulate()
+    {
+        if (!buffer_.valid())
+            throw std::runtime_error("Backend not compiled");
+        buffer_.forwardAndAccumulate(buffer_.vectorWidth());
+    }
+
+    /**
+     * Accumulate numPaths paths given in SoA layout, as for evaluate().
+     * The unused lanes of a final partial batch are not accumulated.
+     */
+    void accumulate(std::size_t numPaths, const Scalar* inputsSoA)
+    {
+        if (!buffer_.valid())
+            throw std::runtime_error("Backend not compiled");
+        buffer_.accumulate(numPaths, inputsSoA);
+    }
+
+    void clearAccumulators() { buffer_.clearAccumulators(); }
+    std::size_t accumulatedPaths() const { return buffer_.accumulatedPaths(); }
+
+    /// Sum of each output over all accumulated paths (numOutputs() values)
+    void getAccumulatedOutputs(Scalar* sums) const { buffer_.getAccumulatedOutputs(sums); }
+
+    /// Sum of each input gradient over all accumulated paths (numInputs() values)
+    void getAccumulatedGradients(Scalar* sums) const { buffer_.getAccumulatedGradients(sums); }
+
     // =========================================================================
     // Additional Accessors
     // =========================================================================
 
-    const std::vector<uint32_t>& inputIds() const { return inputIds_; }
-    const std::vector<uint32_t>& outputIds() const { return outputIds_; }
+    /**
+     * The compiled kernel, for sharing with backends on other threads.
+     * Null before compile().
+     */
+    std::shared_ptr<const ForgeKernel> kernel() const { return kernel_; }
+
+    /// Instruction set that compile() targets
+    ForgeInstructionSet instructionSet() const { return instructionSet_; }
+
+    /**
+     * Compile through a kernel cache, so identical graphs share one kernel.
+     * The cache must outlive this backend; pass nullptr to compile directly.
+     */
+    void setKernelCache(KernelCache* cache) { cache_ = cache; }
+
+    /**
+     * Compile the given const_pool entries as runtime parameters instead of
+     * literals (see ForgeKernel::compile()). Takes effect for the next compile().
+     */
+    void setRuntimeConstants(std::vector<std::size_t> constIndices) { runtimeConstants_ = std::move(constIndices); }
+
+    /**
+     * Run GraphOptimizer (dead-code and common-subexpression elimination,
+     * constant folding) on each graph before compiling it. Runtime constants
+     * are never folded. Takes effect for the next compile().
+     */
+    void setPrepass(bool enable) { prepass_ = enable; }
+
+    /// Node counts of the last prepass (all zero without prepass)
+    const GraphOptimizationStats& prepassStats() const { return prepassStats_; }
+
+    /**
+     * Release the Forge graphs and config right after each compile(),
+     * keeping only the kernels, this backend's buffers and the node-id
+     * mappings (see ForgeKernel::releaseCompileResources()). The kernel can
+     * then not be shared with new backends. Since no buffer can be created
+     * afterwards, compile() creates the forward-only buffer and, for graphs
+     * with several outputs, compiles the VJP kernel and creates its buffer
+     * up front, so forward() and output-adjoint forwardAndBackward() keep
+     * working. Ignored when compiling through a kernel cache, whose kernels
+     * are shared. Takes effect for the next compile().
+     */
+    void setCompact(bool enable) { compact_ = enable; }
+
+    /// Estimated memory held by this backend (all zero before compile())
+    MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage = kernel_ ? kernel_->memoryUsage() : MemoryUsage();
+        usage.bufferBytes = buffer_.estimatedBytes();
+        return usage;
+    }
+
+    /**
+     * Change a runtime constant for all lanes without recompiling.
+     */
+    void setConstant(std::size_t constIndex, Scalar value)
+    {
+        if (!buffer_.valid())
+            throw std::runtime_error("Backend not compiled");
+        buffer_.setConstant(constIndex, value);
+    }
+
+    /**
+     * Values of all runtime constants, in kernel()->runtimeConstants() order.
+     * A backend attached to a shared kernel starts at the values recorded in
+     * the graph the kernel was compiled from, not at this backend's; copy them
+     * with setConstants(master.constants()).
+     */
+    const std::vector<double>& constants() const { return buffer_.constants(); }
+
+    void setConstants(const std::vector<double>& values)
+    {
+        if (!buffer_.valid())
+            throw std::runtime_error("Backend not compiled");
+        buffer_.setConstants(values);
+    }
+
+    /**
+     * Set every runtime constant to its value in jitGraph's const_pool, e.g.
+     * after attaching to a kernel that a KernelCache compiled from another
+     * graph of the same structure.
+     */
+    void loadConstants(const xad::JITGraph& jitGraph)
+    {
+        if (!buffer_.valid())
+            throw std::runtime_error("Backend not compiled");
+        buffer_.loadConstants(jitGraph);
+    }
+
+    const std::vector<uint32_t>& inputIds() const { return kernel_ ? kernel_->inputIds() : noIds(); }
+    const std::vector<uint32_t>& outputIds() const { return kernel_ ? kernel_->outputIds() : noIds(); }
 
     int getVectorWidth() const
     {
-        return buffer_ ? forge_buffer_get_vector_width(buffer_) : 0;
+        return buffer_.getVectorWidth();
     }
 
+    /**
+     * Get buffer index for a node ID (for compatibility with C++ API)
+     */
     std::size_t getBufferIndex(uint32_t nodeId) const
     {
-        return buffer_ ? forge_buffer_get_index(buffer_, nodeId) : SIZE_MAX;
+        return buffer_.getBufferIndex(nodeId);
     }
 
-    ForgeBackend* buffer() { return this; }
-    const ForgeBackend* buffer() const { return this; }
+    /**
+     * Returns this for buffer() compatibility (C++ API returns buffer pointer)
+     */
+    BasicForgeBackend* buffer() { return this; }
+    const BasicForgeBackend* buffer() const { return this; }
 
   private:
-    void cleanup()
+    void compileGraph(const xad::JITGraph& jitGraph)
+    {
+        if (cache_)
+        {
+            attach(cache_->getOrCompile(jitGraph, instructionSet_, useOptimizations_, runtimeConstants_));
+            buffer_.loadConstants(jitGraph);
+            return;
+        }
+        std::shared_ptr<ForgeKernel> kernel =
+            ForgeKernel::compile(jitGraph, instructionSet_, useOptimizations_, runtimeConstants_);
+        attach(kernel);
+        buffer_.loadConstants(jitGraph);
+        if (compact_)
+        {
+            // Not shared yet: this backend holds the only references
+            buffer_.prepareForward();
+            buffer_.prepareVjp();
+            kernel->releaseCompileResources();
+        }
+    }
+
+    void attach(std::shared_ptr<const ForgeKernel> kernel)
+    {
+        if (!kernel)
+            throw std::invalid_argument("ForgeBackend requires a compiled kernel");
+        if (InstructionSet != RUNTIME_INSTRUCTION_SET && kernel->instructionSet() != InstructionSet)
+            throw std::invalid_argument(std::string("ForgeBackend requires a compiled ") +
+                                        instructionSetName(static_cast<ForgeInstructionSet>(InstructionSet)) +
+                                        " kernel");
+        instructionSet_ = kernel->instructionSet();
+        buffer_ = ForgeBuffer(kernel);
+        kernel_ = std::move(kernel);
+    }
+
+    static const char* instructionSetName(ForgeInstructionSet isa)
+    {
+        return isa == FORGE_INSTRUCTION_SET_SSE2_SCALAR   ? "SSE2 scalar"
+               : isa == FORGE_INSTRUCTION_SET_AVX2_PACKED ? "AVX2"
+                                                          : "AVX-512";
+    }
+
+    static const std::vector<uint32_t>& noIds()
     {
-        if (buffer_) { forge_buffer_destroy(buffer_); buffer_ = nullptr; }
-        if (kernel_) { forge_kernel_destroy(kernel_); kernel_ = nullptr; }
-        if (config_) { forge_config_destroy(config_); config_ = nullptr; }
-        if (graph_) { forge_graph_destroy(graph_); graph_ = nullptr; }
+        static const std::vector<uint32_t> empty;
+        return empty;
     }
 
+    ForgeInstructionSet instructionSet_;
     bool useOptimizations_;
-    ForgeGraphHandle graph_;
-    ForgeConfigHandle config_;
-    ForgeKernelHandle kernel_;
-    ForgeBufferHandle buffer_;
-    std::vector<uint32_t> inputIds_;
-    std::vector<uint32_t> outputIds_;
+    KernelCache* cache_;  // not owned, may be null
+    std::vector<std::size_t> runtimeConstants_;  // const_pool indices compiled as parameters
+    bool prepass_;
+    GraphOptimizationStats prepassStats_;
+    bool compact_;
+    std::shared_ptr<const ForgeKernel> kernel_;
+    ForgeBuffer buffer_;
 };
 
+template <class Scalar, int InstructionSet>
+constexpr int BasicForgeBackend<Scalar, InstructionSet>::VECTOR_WIDTH;
+
+/**
+ * Scalar backend: one evaluation per kernel execution, SSE2 scalar code.
+ *
+ * Usage pattern (via JITCompiler):
+ *   xad::JITCompiler<double> jit;
+ *   // ... record graph ...
+ *   jit.setBackend(std::make_unique<xad::forge::ForgeBackend<double>>());
+ *   jit.compile();
+ *   jit.setInput(0, &inputValue);
+ *   double output, gradient;
+ *   jit.forwardAndBackward(&output, &gradient);
+ */
+template <class Scalar>
+using ForgeBackend = BasicForgeBackend<Scalar, FORGE_INSTRUCTION_SET_SSE2_SCALAR>;
+
 }  // namespace forge
 }  // namespace xad
@@ -10,9 +10,8 @@
 //  This backend supports 4 parallel evaluations per kernel execution using
 //  AVX2 SIMD instructions (256-bit YMM registers = 4 doubles). This is useful
 //  for scenarios like Monte Carlo simulations where multiple paths can be
-//  evaluated simultaneously.
-//
-//  Uses the stable C API for binary compatibility across compilers.
+//  evaluated simultaneously. It is BasicForgeBackend (ForgeBackend.hpp)
+//  compiled for the AVX2 instruction set.
 //
 //  Copyright (c) 2025 The xad-forge Authors
 //  https://github.com/da-roth/xad-forge
@@ -35,19 +34,7 @@
 //
 //////////////////////////////////////////////////////////////////////////////
 
-#include <XAD/JITBackendInterface.hpp>
-#include <XAD/JITGraph.hpp>
-
-// Forge C API - stable ABI
-#include <forge_c_api.h>
-
-#include <cstddef>
-#include <cstdint>
-#include <cstring>
-#include <stdexcept>
-#include <string>
-#include <type_traits>
-#include <vector>
+#include <xad-forge/ForgeBackend.hpp>
 
 namespace xad
 {
@@ -57,13 +44,8 @@ namespace forge
 /**
  * AVX2 Backend using Forge C API - implements xad::JITBackend interface.
  *
- * Uses the stable C API for binary compatibility with precompiled Forge packages.
  * Supports 4 parallel evaluations per kernel execution using AVX2 SIMD instructions.
  *
- * Note: Forge currently only supports double precision. This backend is templated
- * to match the JITBackend<Scalar> interface, but only Scalar=double is supported.
- * Using Scalar=float will result in a static_assert failure.
- *
  * Usage pattern (via JITCompiler):
  *   xad::JITCompiler<double> jit;
  *   // ... record graph ...
@@ -76,310 +58,7 @@ namespace forge
  *   jit.forwardAndBackward(outputs, gradients);
  */
 template <class Scalar>
-class ForgeBackendAVX : public xad::JITBackend<Scalar>
-{
-    static_assert(std::is_same<Scalar, double>::value,
-                  "ForgeBackendAVX only supports double precision. Forge does not currently support float.");
-
-  public:
-    /// Number of parallel evaluations (4 for AVX2 backend with double)
-    static constexpr int VECTOR_WIDTH = 4;
-
-    explicit ForgeBackendAVX(bool useGraphOptimizations = false)
-        : useOptimizations_(useGraphOptimizations)
-        , graph_(nullptr)
-        , config_(nullptr)
-        , kernel_(nullptr)
-        , buffer_(nullptr)
-    {
-    }
-
-    ~ForgeBackendAVX() override
-    {
-        cleanup();
-    }
-
-    ForgeBackendAVX(ForgeBackendAVX&& other) noexcept
-        : useOptimizations_(other.useOptimizations_)
-        , graph_(other.graph_)
-        , config_(other.config_)
-        , kernel_(other.kernel_)
-        , buffer_(other.buffer_)
-        , inputIds_(std::move(other.inputIds_))
-        , outputIds_(std::move(other.outputIds_))
-    {
-        other.graph_ = nullptr;
-        other.config_ = nullptr;
-        other.kernel_ = nullptr;
-        other.buffer_ = nullptr;
-    }
-
-    ForgeBackendAVX& operator=(ForgeBackendAVX&& other) noexcept
-    {
-        if (this != &other)
-        {
-            cleanup();
-            useOptimizations_ = other.useOptimizations_;
-            graph_ = other.graph_;
-            config_ = other.config_;
-            kernel_ = other.kernel_;
-            buffer_ = other.buffer_;
-            inputIds_ = std::move(other.inputIds_);
-            outputIds_ = std::move(other.outputIds_);
-            other.graph_ = nullptr;
-            other.config_ = nullptr;
-            other.kernel_ = nullptr;
-            other.buffer_ = nullptr;
-        }
-        return *this;
-    }
-
-    // No copy
-    ForgeBackendAVX(const ForgeBackendAVX&) = delete;
-    ForgeBackendAVX& operator=(const ForgeBackendAVX&) = delete;
-
-    //=========================================================================
-    // JITBackend interface implementation
-    //=========================================================================
-
-    /**
-     * Compile an xad::JITGraph with AVX2 instruction set.
-     */
-    void compile(const xad::JITGraph& jitGraph) override
-    {
-        cleanup();
-
-        // Create graph
-        graph_ = forge_graph_create();
-        if (!graph_)
-            throw std::runtime_error(std::string("Forge graph creation failed: ") + forge_get_last_error());
-
-        // Pre-populate forge's constPool to match XAD's const_pool indices.
-        // This is critical because:
-        // 1. XAD stores constPool indices in CONSTANT nodes' imm field
-        // 2. Multiple CONSTANT nodes can reference the same constPool index
-        // 3. forge_graph_add_constant() creates NEW constPool entries
-        //
-        // By first adding all constants, we ensure forge's constPool matches XAD's.
-        // Then for CONSTANT nodes, we reference these pre-created nodes.
-        std::vector<uint32_t> constNodeIds;
-        constNodeIds.reserve(jitGraph.const_pool.size());
-        for (std::size_t i = 0; i < jitGraph.const_pool.size(); ++i)
-        {
-            uint32_t nodeId = forge_graph_add_constant(graph_, jitGraph.const_pool[i]);
-            if (nodeId == UINT32_MAX)
-                throw std::runtime_error(std::string("Forge add_constant failed: ") + forge_get_last_error());
-            constNodeIds.push_back(nodeId);
-        }
-
-        // Now add the actual graph nodes.
-        // For CONSTANT nodes, we reference the pre-created constant nodes.
-        // For other nodes, we add them normally.
-        inputIds_.clear();
-
-        // Map from XAD node index to Forge node ID
-        std::vector<uint32_t> nodeIdMap(jitGraph.nodeCount());
-
-        for (std::size_t i = 0; i < jitGraph.nodeCount(); ++i)
-        {
-            ForgeOpCode op = static_cast<ForgeOpCode>(jitGraph.nodes[i].op);
-            uint32_t nodeId;
-
-            if (op == FORGE_OP_INPUT)
-            {
-                nodeId = forge_graph_add_input(graph_);
-                if (nodeId == UINT32_MAX)
-                    throw std::runtime_error(std::string("Forge add_input failed: ") + forge_get_last_error());
-                inputIds_.push_back(nodeId);
-            }
-            else if (op == FORGE_OP_CONSTANT)
-            {
-                // XAD stores the constPool index in node.imm
-                // Reference the pre-created constant node
-                uint32_t constIndex = static_cast<uint32_t>(jitGraph.nodes[i].imm);
-                if (constIndex >= constNodeIds.size())
-                    throw std::runtime_error("Invalid constant pool index in JITGraph");
-                nodeId = constNodeIds[constIndex];
-            }
-            else
-            {
-                // Remap operand indices from XAD to Forge node IDs
-                uint32_t a = jitGraph.nodes[i].a;
-                uint32_t b = jitGraph.nodes[i].b;
-                uint32_t c = jitGraph.nodes[i].c;
-
-                if (a < i) a = nodeIdMap[a];
-                if (b < i) b = nodeIdMap[b];
-                if (c < i) c = nodeIdMap[c];
-
-                double imm = jitGraph.nodes[i].imm;
-                int isActive = (jitGraph.nodes[i].flags & xad::JITNodeFlags::IsActive) != 0 ? 1 : 0;
-
-                nodeId = forge_graph_add_node(graph_, op, a, b, c, imm, isActive, 0);
-                if (nodeId == UINT32_MAX)
-                    throw std::runtime_error(std::string("Forge add_node failed: ") + forge_get_last_error());
-            }
-
-            nodeIdMap[i] = nodeId;
-        }
-
-        // Mark outputs (remap from XAD indices to Forge node IDs)
-        outputIds_.clear();
-        for (auto xadOutputId : jitGraph.output_ids)
-        {
-            uint32_t forgeOutputId = nodeIdMap[xadOutputId];
-            outputIds_.push_back(forgeOutputId);
-            ForgeError err = forge_graph_mark_output(graph_, forgeOutputId);
-            if (err != FORGE_SUCCESS)
-                throw std::runtime_error(std::string("Forge mark_output failed: ") + forge_get_last_error());
-        }
-
-        // Mark diff inputs (remap from XAD indices to Forge node IDs)
-        for (auto xadInputId : jitGraph.input_ids)
-        {
-            uint32_t forgeInputId = nodeIdMap[xadInputId];
-            ForgeError err = forge_graph_mark_diff_input(graph_, forgeInputId);
-            if (err != FORGE_SUCCESS)
-                throw std::runtime_error(std::string("Forge mark_diff_input failed: ") + forge_get_last_error());
-        }
-
-        // Propagate needsGradient flags through the graph
-        {
-            ForgeError err = forge_graph_propagate_gradients(graph_);
-            if (err != FORGE_SUCCESS)
-                throw std::runtime_error(std::string("Forge propagate_gradients failed: ") + forge_get_last_error());
-        }
-
-        // Create config with AVX2
-        config_ = useOptimizations_ ? forge_config_create_fast() : forge_config_create_default();
-        if (!config_)
-            throw std::runtime_error("Forge config creation failed");
-
-        forge_config_set_instruction_set(config_, FORGE_INSTRUCTION_SET_AVX2_PACKED);
-
-        // Compile
-        kernel_ = forge_compile(graph_, config_);
-        if (!kernel_)
-            throw std::runtime_error(std::string("Forge AVX2 compilation failed: ") + forge_get_last_error());
-
-        // Create buffer
-        buffer_ = forge_buffer_create(graph_, kernel_);
-        if (!buffer_)
-            throw std::runtime_error(std::string("Forge AVX2 buffer creation failed: ") + forge_get_last_error());
-    }
-
-    void reset() override
-    {
-        cleanup();
-        inputIds_.clear();
-        outputIds_.clear();
-    }
-
-    std::size_t vectorWidth() const override { return VECTOR_WIDTH; }
-    std::size_t numInputs() const override { return inputIds_.size(); }
-    std::size_t numOutputs() const override { return outputIds_.size(); }
-
-    /**
-     * Set 4 values for an input (one per parallel evaluation).
-     */
-    void setInput(std::size_t inputIndex, const Scalar* values) override
-    {
-        if (inputIndex >= inputIds_.size())
-            throw std::runtime_error("Input index out of range");
-        forge_buffer_set_lanes(buffer_, inputIds_[inputIndex], values);
-    }
-
-    /**
-     * Execute forward pass only.
-     */
-    void forward(Scalar* outputs) override
-    {
-        if (!kernel_ || !buffer_)
-            throw std::runtime_error("Backend not compiled");
-
-        // Clear gradients and execute (Forge always does forward+backward)
-        forge_buffer_clear_gradients(buffer_);
-        ForgeError err = forge_execute(kernel_, buffer_);
-        if (err != FORGE_SUCCESS)
-            throw std::runtime_error(std::string("Forge execution failed: ") + forge_get_last_error());
-
-        // Get outputs
-        for (std::size_t i = 0; i < outputIds_.size(); ++i)
-        {
-            forge_buffer_get_lanes(buffer_, outputIds_[i], outputs + i * VECTOR_WIDTH);
-        }
-    }
-
-    /**
-     * Execute forward + backward in one call.
-     */
-    void forwardAndBackward(Scalar* outputs, Scalar* inputGradients) override
-    {
-        if (!kernel_ || !buffer_)
-            throw std::runtime_error("Backend not compiled");
-
-        // Clear gradients and execute
-        forge_buffer_clear_gradients(buffer_);
-        ForgeError err = forge_execute(kernel_, buffer_);
-        if (err != FORGE_SUCCESS)
-            throw std::runtime_error(std::string("Forge execution failed: ") + forge_get_last_error());
-
-        // Get outputs
-        for (std::size_t i = 0; i < outputIds_.size(); ++i)
-        {
-            forge_buffer_get_lanes(buffer_, outputIds_[i], outputs + i * VECTOR_WIDTH);
-        }
-
-        // Get input gradients
-        for (std::size_t i = 0; i < inputIds_.size(); ++i)
-        {
-            forge_buffer_get_gradient_lanes(buffer_, &inputIds_[i], 1, inputGradients + i * VECTOR_WIDTH);
-        }
-    }
-
-    // =========================================================================
-    // Additional Accessors
-    // =========================================================================
-
-    const std::vector<uint32_t>& inputIds() const { return inputIds_; }
-    const std::vector<uint32_t>& outputIds() const { return outputIds_; }
-
-    int getVectorWidth() const
-    {
-        return buffer_ ? forge_buffer_get_vector_width(buffer_) : 0;
-    }
-
-    /**
-     * Get buffer index for a node ID (for compatibility with C++ API)
-     */
-    std::size_t getBufferIndex(uint32_t nodeId) const
-    {
-        return buffer_ ? forge_buffer_get_index(buffer_, nodeId) : SIZE_MAX;
-    }
-
-    /**
-     * Returns this for buffer() compatibility (C++ API returns buffer pointer)
-     */
-    ForgeBackendAVX* buffer() { return this; }
-    const ForgeBackendAVX* buffer() const { return this; }
-
-  private:
-    void cleanup()
-    {
-        if (buffer_) { forge_buffer_destroy(buffer_); buffer_ = nullptr; }
-        if (kernel_) { forge_kernel_destroy(kernel_); kernel_ = nullptr; }
-        if (config_) { forge_config_destroy(config_); config_ = nullptr; }
-        if (graph_) { forge_graph_destroy(graph_); graph_ = nullptr; }
-    }
-
-    bool useOptimizations_;
-    ForgeGraphHandle graph_;
-    ForgeConfigHandle config_;
-    ForgeKernelHandle kernel_;
-    ForgeBufferHandle buffer_;
-    std::vector<uint32_t> inputIds_;
-    std::vector<uint32_t> outputIds_;
-};
+using ForgeBackendAVX = BasicForgeBackend<Scalar, FORGE_INSTRUCTION_SET_AVX2_PACKED>;
 
 }  // namespace forge
 }  // namespace xad
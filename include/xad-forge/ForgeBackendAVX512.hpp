@@ -0,0 +1,70 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  ForgeBackendAVX512 - AVX-512 backend using Forge C API
+//
+//  This file is part of xad-forge, providing Forge JIT compilation
+//  as a backend for XAD automatic differentiation.
+//
+//  This backend supports 8 parallel evaluations per kernel execution using
+//  AVX-512F SIMD instructions (512-bit ZMM registers = 8 doubles). It is
+//  BasicForgeBackend (ForgeBackend.hpp) compiled for the AVX-512 instruction
+//  set, so it has the same interface as ForgeBackendAVX, and is only
+//  available when the Forge C API provides an AVX-512 instruction set
+//  (XAD_FORGE_HAS_AVX512).
+//
+//  Copyright (c) 2025 The xad-forge Authors
+//  https://github.com/da-roth/xad-forge
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <xad-forge/ForgeBackend.hpp>
+
+namespace xad
+{
+namespace forge
+{
+
+#if XAD_FORGE_HAS_AVX512
+
+/**
+ * AVX-512 Backend using Forge C API - implements xad::JITBackend interface.
+ *
+ * Supports 8 parallel evaluations per kernel execution using AVX-512F SIMD instructions.
+ * The host CPU must support AVX-512F.
+ *
+ * Usage pattern (via JITCompiler):
+ *   xad::JITCompiler<double> jit;
+ *   // ... record graph ...
+ *   jit.setBackend(std::make_unique<xad::forge::ForgeBackendAVX512<double>>());
+ *   jit.compile();
+ *
+ *   double inputs[8] = {1, 2, 3, 4, 5, 6, 7, 8};  // 8 parallel evaluations
+ *   jit.setInput(0, inputs);
+ *   double outputs[8], gradients[8];
+ *   jit.forwardAndBackward(outputs, gradients);
+ */
+template <class Scalar>
+using ForgeBackendAVX512 = BasicForgeBackend<Scalar, FORGE_INSTRUCTION_SET_AVX512_PACKED>;
+
+#endif  // XAD_FORGE_HAS_AVX512
+
+}  // namespace forge
+}  // namespace xad
@@ -0,0 +1,70 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  ForgeBackendAuto - Backend choosing the instruction set at runtime
+//
+//  This file is part of xad-forge, providing Forge JIT compilation
+//  as a backend for XAD automatic differentiation.
+//
+//  This backend detects the host CPU's SIMD support via CPUID when it is
+//  constructed and compiles for the widest instruction set available:
+//  AVX-512 (8 doubles, if supported by the Forge C API), AVX2 (4 doubles) or
+//  SSE2 scalar. One binary can thus be deployed across machines of different
+//  generations and still use the fastest kernel on each. It is
+//  BasicForgeBackend (ForgeBackend.hpp) with the instruction set chosen at
+//  runtime.
+//
+//  Copyright (c) 2025 The xad-forge Authors
+//  https://github.com/da-roth/xad-forge
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <xad-forge/ForgeBackend.hpp>
+
+namespace xad
+{
+namespace forge
+{
+
+/**
+ * Runtime-dispatched Backend using Forge C API - implements xad::JITBackend interface.
+ *
+ * The instruction set, and with it vectorWidth(), is fixed at construction:
+ * bestInstructionSet() by default, or an explicitly requested one, which
+ * must be supported by the host CPU. A backend attached to a compiled kernel
+ * adopts the kernel's instruction set.
+ *
+ * Usage pattern (via JITCompiler):
+ *   xad::JITCompiler<double> jit;
+ *   // ... record graph ...
+ *   auto backend = std::make_unique<xad::forge::ForgeBackendAuto<double>>();
+ *   const std::size_t width = backend->vectorWidth();  // 1, 4 or 8
+ *   jit.setBackend(std::move(backend));
+ *   jit.compile();
+ *
+ *   std::vector<double> inputs(width), outputs(width), gradients(width);
+ *   jit.setInput(0, inputs.data());
+ *   jit.forwardAndBackward(outputs.data(), gradients.data());
+ */
+template <class Scalar>
+using ForgeBackendAuto = BasicForgeBackend<Scalar, RUNTIME_INSTRUCTION_SET>;
+
+}  // namespace forge
+}  // namespace xad
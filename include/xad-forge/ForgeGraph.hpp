@@ -0,0 +1,561 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  ForgeGraph - xad::JITGraph translated to Forge, shared between compilations
+//
+//  This file is part of xad-forge, providing Forge JIT compilation
+//  as a backend for XAD automatic differentiation.
+//
+//  Translating a JITGraph into Forge graphs is independent of the target
+//  instruction set. ForgeGraph does it once; any number of ForgeKernel
+//  objects (SSE2, AVX2, AVX-512, ...) can then be compiled from the same
+//  translation, so a large graph is not walked again for every variant.
+//
+//  Copyright (c) 2025 The xad-forge Authors
+//  https://github.com/da-roth/xad-forge
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <XAD/JITGraph.hpp>
+
+// Forge C API - stable ABI
+#include <forge_c_api.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace xad
+{
+namespace forge
+{
+
+/**
+ * Size assumptions behind every estimatedBytes() and memoryUsage() figure.
+ * The Forge C API reports neither graph, code nor buffer sizes, so these
+ * are estimates derived from the node count, not measurements.
+ */
+struct MemoryEstimate
+{
+    /// Forge graph node with its operands, immediate, flags and gradient bookkeeping
+    static std::size_t graphBytesPerNode() { return 64; }
+    /// Generated code per node of a forward+backward or VJP kernel
+    static std::size_t codeBytesPerNode() { return 64; }
+    /// Generated code per node of a forward-only kernel
+    static std::size_t forwardCodeBytesPerNode() { return 32; }
+    /// One value (or gradient) array of an execution buffer, per node
+    static std::size_t valueBytesPerNode(std::size_t vectorWidth) { return sizeof(double) * vectorWidth; }
+};
+
+/**
+ * Forge translation of an xad::JITGraph.
+ *
+ * Holds two Forge graphs: one with gradient propagation for
+ * forward+backward kernels and a forward-only one without diff inputs.
+ * Graphs with several outputs get a third one for vector-Jacobian products
+ * (see vjpHandle()).
+ * Created through ForgeGraph::translate() and only handed out as
+ * std::shared_ptr<const ForgeGraph>, so kernels for several instruction sets
+ * can be compiled from it, also concurrently (see ForgeKernel::compileAll()).
+ *
+ * Only the forward+backward graph is translated up front. The forward-only
+ * and VJP graphs are translated on the first forwardHandle() or vjpHandle()
+ * call, from a copy of the JITGraph that is kept until both exist; that step
+ * is serialized internally. Callers that never run forward() or
+ * vector-Jacobian products thus pay for the copy, not for further Forge
+ * graphs.
+ */
+class ForgeGraph
+{
+  public:
+    /**
+     * Translate jitGraph.
+     *
+     * runtimeConstants lists const_pool indices that become runtime
+     * parameters instead of being baked into the code. Their values can be
+     * changed per buffer with ForgeBuffer::setConstant() without recompiling;
+     * they start at the recorded values. Constants that XAD stored directly
+     * in an operation's immediate are not in the const_pool and stay fixed.
+     */
+    static std::shared_ptr<const ForgeGraph> translate(const xad::JITGraph& jitGraph,
+                                                       const std::vector<std::size_t>& runtimeConstants =
+                                                           std::vector<std::size_t>())
+    {
+        return std::shared_ptr<const ForgeGraph>(new ForgeGraph(jitGraph, runtimeConstants));
+    }
+
+    ~ForgeGraph()
+    {
+        cleanup();
+    }
+
+    // No copy (shared through std::shared_ptr)
+    ForgeGraph(const ForgeGraph&) = delete;
+    ForgeGraph& operator=(const ForgeGraph&) = delete;
+
+    /// Forge graph with gradient propagation
+    ForgeGraphHandle handle() const { return graph_; }
+    /**
+     * Forge graph without diff inputs (primal sweep only), translated on the
+     * first call. Null for copies from withoutHandles() that never had it.
+     */
+    ForgeGraphHandle forwardHandle() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!forwardGraph_ && source_)
+        {
+            Target target;
+            target.withGradients = false;
+            target.inputIds = &forwardInputIds_;
+            target.outputIds = &forwardOutputIds_;
+            target.parameterIds = &forwardParameterIds_;
+            forwardGraph_ = translateDeferred(target);
+            releaseSource();
+        }
+        return forwardGraph_;
+    }
+    /**
+     * Forge graph for vector-Jacobian products, translated on the first
+     * call, or null for graphs with at most one output. Its only output is
+     * sum_k seed_k * output_k, where the seeds are extra inputs; the inputs
+     * and the seeds are diff inputs, so the gradient of seed k is the value
+     * of output k.
+     */
+    ForgeGraphHandle vjpHandle() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!vjpGraph_ && source_ && hasVjp())
+        {
+            std::vector<uint32_t> vjpOutputIds;
+            Target target;
+            target.withGradients = true;
+            target.inputIds = &vjpInputIds_;
+            target.outputIds = &vjpOutputIds;
+            target.parameterIds = &vjpParameterIds_;
+            target.seedIds = &vjpSeedIds_;
+            vjpGraph_ = translateDeferred(target);
+            releaseSource();
+        }
+        return vjpGraph_;
+    }
+    /// A single output is weighted on the host, so only several outputs need the VJP graph
+    bool hasVjp() const { return outputIds_.size() > 1; }
+
+    /// Nodes plus constant-pool entries of the source graph
+    std::size_t numNodes() const { return numNodes_; }
+    std::size_t numInputs() const { return inputIds_.size(); }
+    /// Wall-clock time spent translating so far, in milliseconds
+    double translationMs() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return translationMs_;
+    }
+    std::size_t numOutputs() const { return outputIds_.size(); }
+
+    const std::vector<uint32_t>& inputIds() const { return inputIds_; }
+    const std::vector<uint32_t>& outputIds() const { return outputIds_; }
+    /// Node ids in the forward-only graph; filled by forwardHandle()
+    const std::vector<uint32_t>& forwardInputIds() const { return forwardInputIds_; }
+    const std::vector<uint32_t>& forwardOutputIds() const { return forwardOutputIds_; }
+    /// Node ids in the VJP graph; filled by vjpHandle()
+    const std::vector<uint32_t>& vjpInputIds() const { return vjpInputIds_; }
+    /// Seed input of each output in the VJP graph, in output order
+    const std::vector<uint32_t>& vjpSeedIds() const { return vjpSeedIds_; }
+
+    /// Sorted const_pool indices translated as runtime parameters
+    const std::vector<std::size_t>& runtimeConstants() const { return runtimeConstants_; }
+    /// Forge node ids of the runtime parameters, in runtimeConstants() order
+    const std::vector<uint32_t>& parameterIds() const { return parameterIds_; }
+    const std::vector<uint32_t>& forwardParameterIds() const { return forwardParameterIds_; }
+    const std::vector<uint32_t>& vjpParameterIds() const { return vjpParameterIds_; }
+    /// Recorded values of the runtime parameters
+    const std::vector<double>& parameterDefaults() const { return parameterDefaults_; }
+
+    /// Whether the Forge graphs are held; false for copies from withoutHandles()
+    bool hasHandles() const { return graph_ != nullptr; }
+
+    /**
+     * Copy of the node-id mappings and parameter data without the Forge
+     * graphs. Enough to run kernels compiled from this graph with buffers
+     * that already exist, but not to compile or create buffers.
+     */
+    std::shared_ptr<const ForgeGraph> withoutHandles() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::shared_ptr<ForgeGraph> copy(new ForgeGraph());
+        copy->numNodes_ = numNodes_;
+        copy->translationMs_ = translationMs_;
+        copy->inputIds_ = inputIds_;
+        copy->outputIds_ = outputIds_;
+        copy->forwardInputIds_ = forwardInputIds_;
+        copy->forwardOutputIds_ = forwardOutputIds_;
+        copy->vjpInputIds_ = vjpInputIds_;
+        copy->vjpSeedIds_ = vjpSeedIds_;
+        copy->runtimeConstants_ = runtimeConstants_;
+        copy->parameterIds_ = parameterIds_;
+        copy->forwardParameterIds_ = forwardParameterIds_;
+        copy->vjpParameterIds_ = vjpParameterIds_;
+        copy->parameterDefaults_ = parameterDefaults_;
+        return copy;
+    }
+
+    /**
+     * Approximate bytes held: the Forge graphs (see MemoryEstimate), the
+     * JITGraph copy kept for deferred translation, and the id mappings.
+     */
+    std::size_t estimatedBytes() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const std::size_t sourceBytes =
+            source_ ? sizeof(source_->nodes[0]) * source_->nodes.size() +
+                          sizeof(double) * source_->const_pool.size() +
+                          sizeof(uint32_t) * (source_->input_ids.size() + source_->output_ids.size())
+                    : 0;
+        const std::size_t numGraphs = (graph_ ? 1 : 0) + (forwardGraph_ ? 1 : 0) + (vjpGraph_ ? 1 : 0);
+        const std::size_t handleBytes = numGraphs * numNodes_ * MemoryEstimate::graphBytesPerNode();
+        const std::size_t idBytes =
+            sizeof(uint32_t) * (inputIds_.size() + outputIds_.size() + forwardInputIds_.size() +
+                                forwardOutputIds_.size() + parameterIds_.size() + forwardParameterIds_.size() +
+                                vjpInputIds_.size() + vjpSeedIds_.size() + vjpParameterIds_.size());
+        return handleBytes + sourceBytes + idBytes +
+               (sizeof(std::size_t) + sizeof(double)) * runtimeConstants_.size();
+    }
+
+    /**
+     * Position of a const_pool index in runtimeConstants(), or
+     * runtimeConstants().size() if it is not a runtime parameter.
+     */
+    std::size_t parameterSlot(std::size_t constIndex) const
+    {
+        std::vector<std::size_t>::const_iterator it =
+            std::lower_bound(runtimeConstants_.begin(), runtimeConstants_.end(), constIndex);
+        if (it == runtimeConstants_.end() || *it != constIndex)
+            return runtimeConstants_.size();
+        return static_cast<std::size_t>(it - runtimeConstants_.begin());
+    }
+
+  private:
+    friend class SegmentedKernel;  // translates its segments with translateGraph()
+
+    ForgeGraph()
+        : graph_(nullptr)
+        , forwardGraph_(nullptr)
+        , vjpGraph_(nullptr)
+        , numNodes_(0)
+        , translationMs_(0.0)
+    {
+    }
+
+    ForgeGraph(const xad::JITGraph& jitGraph, const std::vector<std::size_t>& runtimeConstants)
+        : graph_(nullptr)
+        , forwardGraph_(nullptr)
+        , vjpGraph_(nullptr)
+        , numNodes_(jitGraph.nodeCount() + jitGraph.const_pool.size())
+        , translationMs_(0.0)
+        , runtimeConstants_(runtimeConstants)
+    {
+        std::sort(runtimeConstants_.begin(), runtimeConstants_.end());
+        runtimeConstants_.erase(std::unique(runtimeConstants_.begin(), runtimeConstants_.end()),
+                                runtimeConstants_.end());
+        for (std::size_t i = 0; i < runtimeConstants_.size(); ++i)
+        {
+            if (runtimeConstants_[i] >= jitGraph.const_pool.size())
+                throw std::invalid_argument("Runtime constant index out of range");
+            parameterDefaults_.push_back(jitGraph.const_pool[runtimeConstants_[i]]);
+        }
+
+        try
+        {
+            build(jitGraph);
+        }
+        catch (...)
+        {
+            cleanup();
+            throw;
+        }
+    }
+
+    void build(const xad::JITGraph& jitGraph)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        graph_ = forge_graph_create();
+        if (!graph_)
+            throw std::runtime_error(std::string("Forge graph creation failed: ") + forge_get_last_error());
+
+        Target target;
+        target.graph = graph_;
+        target.withGradients = true;
+        target.inputIds = &inputIds_;
+        target.outputIds = &outputIds_;
+        target.parameterIds = &parameterIds_;
+        translateGraph(jitGraph, runtimeConstants_, target);
+
+        // Forward-only graph (same nodes, but no diff inputs, so no adjoint
+        // code) and VJP graph: translated by forwardHandle() and vjpHandle()
+        // when first needed
+        source_.reset(new xad::JITGraph(jitGraph));
+
+        translationMs_ =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // One Forge graph being filled by translateGraph()
+    struct Target
+    {
+        Target()
+            : graph(nullptr)
+            , withGradients(false)
+            , inputIds(nullptr)
+            , outputIds(nullptr)
+            , parameterIds(nullptr)
+            , seedIds(nullptr)
+        {
+        }
+
+        ForgeGraphHandle graph;
+        bool withGradients;
+        std::vector<uint32_t>* inputIds;
+        std::vector<uint32_t>* outputIds;
+        std::vector<uint32_t>* parameterIds;
+        std::vector<uint32_t>* seedIds;  // non-null: mark the seeded sum of the outputs instead
+        std::vector<uint32_t> constNodeIds;
+        std::vector<uint32_t> nodeIdMap;  // XAD node index -> Forge node id
+    };
+
+    /**
+     * Translate source_ into a new Forge graph for target and return it.
+     * Called with mutex_ held.
+     */
+    ForgeGraphHandle translateDeferred(Target& target) const
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        target.graph = forge_graph_create();
+        if (!target.graph)
+            throw std::runtime_error(std::string("Forge graph creation failed: ") + forge_get_last_error());
+        try
+        {
+            translateGraph(*source_, runtimeConstants_, target);
+        }
+        catch (...)
+        {
+            forge_graph_destroy(target.graph);
+            throw;
+        }
+        translationMs_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return target.graph;
+    }
+
+    /// Drop source_ once no graph is left to translate. Called with mutex_ held.
+    void releaseSource() const
+    {
+        if (forwardGraph_ && (vjpGraph_ || !hasVjp()))
+            source_.reset();
+    }
+
+    /**
+     * Translate an xad::JITGraph into the (empty) Forge graph of target.
+     *
+     * With withGradients=false no node is marked active and no diff inputs
+     * are marked, so the compiled kernel only contains the primal sweep.
+     * Const-pool entries listed in runtimeConstants (sorted) become
+     * non-differentiated inputs, returned in parameterIds. A target with
+     * seedIds gets the VJP outputs described at vjpHandle().
+     */
+    static void translateGraph(const xad::JITGraph& jitGraph, const std::vector<std::size_t>& runtimeConstants,
+                               Target& target)
+    {
+        const std::size_t numNodes = jitGraph.nodeCount();
+        const std::size_t numConstants = jitGraph.const_pool.size();
+        target.constNodeIds.resize(numConstants);
+        target.nodeIdMap.resize(numNodes);
+        target.inputIds->clear();
+        target.inputIds->reserve(jitGraph.input_ids.size());
+        target.outputIds->clear();
+        target.outputIds->reserve(jitGraph.output_ids.size());
+        target.parameterIds->clear();
+        target.parameterIds->reserve(runtimeConstants.size());
+
+        // Pre-populate forge's constPool to match XAD's const_pool indices.
+        // This is critical because:
+        // 1. XAD stores constPool indices in CONSTANT nodes' imm field
+        // 2. Multiple CONSTANT nodes can reference the same constPool index
+        // 3. forge_graph_add_constant() creates NEW constPool entries
+        //
+        // By first adding all constants, we ensure forge's constPool matches XAD's.
+        // Then for CONSTANT nodes, we reference these pre-created nodes.
+        std::size_t nextParameter = 0;
+        for (std::size_t i = 0; i < numConstants; ++i)
+        {
+            // Runtime parameter: an input that is never marked as diff input
+            if (nextParameter < runtimeConstants.size() && runtimeConstants[nextParameter] == i)
+            {
+                ++nextParameter;
+                uint32_t nodeId = checkNode(forge_graph_add_input(target.graph), "add_input");
+                target.parameterIds->push_back(nodeId);
+                target.constNodeIds[i] = nodeId;
+            }
+            else
+            {
+                target.constNodeIds[i] =
+                    checkNode(forge_graph_add_constant(target.graph, jitGraph.const_pool[i]), "add_constant");
+            }
+        }
+
+        // Now add the actual graph nodes.
+        // For CONSTANT nodes, we reference the pre-created constant nodes.
+        // For other nodes, we add them normally.
+        for (std::size_t i = 0; i < numNodes; ++i)
+        {
+            const auto& node = jitGraph.nodes[i];
+            const ForgeOpCode op = static_cast<ForgeOpCode>(node.op);
+
+            if (op == FORGE_OP_INPUT)
+            {
+                uint32_t nodeId = checkNode(forge_graph_add_input(target.graph), "add_input");
+                target.inputIds->push_back(nodeId);
+                target.nodeIdMap[i] = nodeId;
+            }
+            else if (op == FORGE_OP_CONSTANT)
+            {
+                // XAD stores the constPool index in node.imm
+                // Reference the pre-created constant node
+                const uint32_t constIndex = static_cast<uint32_t>(node.imm);
+                if (constIndex >= numConstants)
+                    throw std::runtime_error("Invalid constant pool index in JITGraph");
+                target.nodeIdMap[i] = target.constNodeIds[constIndex];
+            }
+            else
+            {
+                // Remap operand indices from XAD to Forge node IDs
+                uint32_t a = node.a;
+                uint32_t b = node.b;
+                uint32_t c = node.c;
+                if (a < i) a = target.nodeIdMap[a];
+                if (b < i) b = target.nodeIdMap[b];
+                if (c < i) c = target.nodeIdMap[c];
+
+                const int isActive = target.withGradients && (node.flags & xad::JITNodeFlags::IsActive) != 0 ? 1 : 0;
+                target.nodeIdMap[i] =
+                    checkNode(forge_graph_add_node(target.graph, op, a, b, c, node.imm, isActive, 0), "add_node");
+            }
+        }
+
+        // Mark outputs (remap from XAD indices to Forge node IDs)
+        for (auto xadOutputId : jitGraph.output_ids)
+        {
+            uint32_t forgeOutputId = target.nodeIdMap[xadOutputId];
+            target.outputIds->push_back(forgeOutputId);
+            if (!target.seedIds)
+                checkError(forge_graph_mark_output(target.graph, forgeOutputId), "mark_output");
+        }
+        if (target.seedIds)
+            addSeededSum(target);
+
+        if (!target.withGradients)
+            return;
+
+        // Mark diff inputs (remap from XAD indices to Forge node IDs)
+        for (auto xadInputId : jitGraph.input_ids)
+            checkError(forge_graph_mark_diff_input(target.graph, target.nodeIdMap[xadInputId]), "mark_diff_input");
+        if (target.seedIds)
+        {
+            for (std::size_t k = 0; k < target.seedIds->size(); ++k)
+                checkError(forge_graph_mark_diff_input(target.graph, (*target.seedIds)[k]), "mark_diff_input");
+        }
+
+        // Propagate needsGradient flags through the graph
+        checkError(forge_graph_propagate_gradients(target.graph), "propagate_gradients");
+    }
+
+    /**
+     * Add one seed input per output and mark sum_k seed_k * output_k as the
+     * target's only output. Seeding it with 1 runs the backward sweep with
+     * output adjoints seed_k.
+     */
+    static void addSeededSum(Target& target)
+    {
+        const std::vector<uint32_t>& outputIds = *target.outputIds;
+        target.seedIds->clear();
+        uint32_t sum = 0;
+        for (std::size_t k = 0; k < outputIds.size(); ++k)
+        {
+            const uint32_t seed = checkNode(forge_graph_add_input(target.graph), "add_input");
+            target.seedIds->push_back(seed);
+            const uint32_t term =
+                checkNode(forge_graph_add_node(target.graph, FORGE_OP_MUL, seed, outputIds[k], 0, 0.0, 1, 0), "add_node");
+            sum = k == 0 ? term
+                         : checkNode(forge_graph_add_node(target.graph, FORGE_OP_ADD, sum, term, 0, 0.0, 1, 0), "add_node");
+        }
+        checkError(forge_graph_mark_output(target.graph, sum), "mark_output");
+    }
+
+    static uint32_t checkNode(uint32_t nodeId, const char* call)
+    {
+        if (nodeId == UINT32_MAX)
+            throw std::runtime_error(std::string("Forge ") + call + " failed: " + forge_get_last_error());
+        return nodeId;
+    }
+
+    static void checkError(ForgeError err, const char* call)
+    {
+        if (err != FORGE_SUCCESS)
+            throw std::runtime_error(std::string("Forge ") + call + " failed: " + forge_get_last_error());
+    }
+
+    void cleanup()
+    {
+        if (vjpGraph_) { forge_graph_destroy(vjpGraph_); vjpGraph_ = nullptr; }
+        if (forwardGraph_) { forge_graph_destroy(forwardGraph_); forwardGraph_ = nullptr; }
+        if (graph_) { forge_graph_destroy(graph_); graph_ = nullptr; }
+    }
+
+    ForgeGraphHandle graph_;
+    mutable ForgeGraphHandle forwardGraph_;  // translated lazily under mutex_
+    mutable ForgeGraphHandle vjpGraph_;  // only for graphs with several outputs, likewise
+    std::size_t numNodes_;
+    mutable double translationMs_;
+    std::vector<uint32_t> inputIds_;
+    std::vector<uint32_t> outputIds_;
+    mutable std::vector<uint32_t> forwardInputIds_;
+    mutable std::vector<uint32_t> forwardOutputIds_;
+    mutable std::vector<uint32_t> vjpInputIds_;
+    mutable std::vector<uint32_t> vjpSeedIds_;
+
+    // Const-pool entries translated as runtime parameters
+    std::vector<std::size_t> runtimeConstants_;
+    std::vector<uint32_t> parameterIds_;
+    mutable std::vector<uint32_t> forwardParameterIds_;
+    mutable std::vector<uint32_t> vjpParameterIds_;
+    std::vector<double> parameterDefaults_;
+
+    // Source of the graphs not yet translated, released once all are
+    mutable std::unique_ptr<const xad::JITGraph> source_;
+    mutable std::mutex mutex_;
+};
+
+}  // namespace forge
+}  // namespace xad
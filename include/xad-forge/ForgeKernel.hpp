@@ -0,0 +1,1201 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  ForgeKernel - Shared compiled kernel and per-thread execution buffers
+//
+//  This file is part of xad-forge, providing Forge JIT compilation
+//  as a backend for XAD automatic differentiation.
+//
+//  ForgeKernel holds everything produced by compilation (the translated
+//  ForgeGraph, config and kernel). It is immutable once built and can be
+//  shared between threads through std::shared_ptr. ForgeBuffer holds the execution state for one
+//  thread: the Forge buffer with input, intermediate and gradient values.
+//  Compiling once and creating one ForgeBuffer per worker avoids compiling
+//  the same graph on every thread.
+//
+//  Uses the stable C API for binary compatibility across compilers.
+//
+//  Copyright (c) 2025 The xad-forge Authors
+//  https://github.com/da-roth/xad-forge
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <XAD/JITGraph.hpp>
+
+#include <xad-forge/ForgeGraph.hpp>
+
+// Forge C API - stable ABI
+#include <forge_c_api.h>
+
+// Set by CMake when the Forge C API provides FORGE_INSTRUCTION_SET_AVX512_PACKED
+#ifndef XAD_FORGE_HAS_AVX512
+#define XAD_FORGE_HAS_AVX512 0
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace xad
+{
+namespace forge
+{
+
+/**
+ * Wall-clock timings of the phases that produced a ForgeKernel.
+ */
+struct CompileStats
+{
+    std::size_t nodes;        ///< JITGraph nodes plus const-pool entries
+    double translateMs;       ///< JITGraph -> Forge graphs so far, including deferred ones (shared by kernels of one ForgeGraph)
+    double compileMs;         ///< Forge compilation of the forward+backward kernel
+    double forwardCompileMs;  ///< Forge compilation of the forward-only kernel, 0 until first forward()
+    double vjpCompileMs;      ///< Forge compilation of the VJP kernel, 0 until first use
+};
+
+/**
+ * Estimated memory held for one backend, in bytes. The Forge C API does not
+ * report sizes, so these are derived from node counts.
+ */
+struct MemoryUsage
+{
+    MemoryUsage()
+        : graphBytes(0)
+        , kernelBytes(0)
+        , bufferBytes(0)
+    {
+    }
+
+    std::size_t graphBytes;   ///< translated Forge graphs and id mappings
+    std::size_t kernelBytes;  ///< generated code
+    std::size_t bufferBytes;  ///< execution buffers and accumulators
+
+    std::size_t total() const { return graphBytes + kernelBytes + bufferBytes; }
+};
+
+/**
+ * Compiled Forge kernel for an xad::JITGraph.
+ *
+ * Created through ForgeKernel::compile() and shared as
+ * std::shared_ptr<const ForgeKernel>. Through a const kernel it is only
+ * read, so one instance can serve any number of ForgeBuffer objects on
+ * different threads. Only the owner of the non-const kernel returned by
+ * compile() can call releaseCompileResources(). The forward-only and VJP variants are compiled on first
+ * request; that step is serialized internally.
+ *
+ * The translated graph is held as a shared ForgeGraph, so kernels for
+ * several instruction sets can be compiled from one translation.
+ */
+class ForgeKernel
+{
+  public:
+    /**
+     * Translate jitGraph and compile it for the given instruction set.
+     * See ForgeGraph::translate() for runtimeConstants.
+     */
+    static std::shared_ptr<ForgeKernel> compile(const xad::JITGraph& jitGraph,
+                                                ForgeInstructionSet instructionSet,
+                                                bool useGraphOptimizations = false,
+                                                const std::vector<std::size_t>& runtimeConstants =
+                                                    std::vector<std::size_t>())
+    {
+        return compile(ForgeGraph::translate(jitGraph, runtimeConstants), instructionSet, useGraphOptimizations);
+    }
+
+    /**
+     * Compile an already translated graph for the given instruction set.
+     */
+    static std::shared_ptr<ForgeKernel> compile(std::shared_ptr<const ForgeGraph> graph,
+                                                ForgeInstructionSet instructionSet,
+                                                bool useGraphOptimizations = false)
+    {
+        if (!graph || !graph->hasHandles())
+            throw std::invalid_argument("ForgeKernel::compile requires a translated graph");
+        return std::shared_ptr<ForgeKernel>(
+            new ForgeKernel(std::move(graph), instructionSet, useGraphOptimizations));
+    }
+
+    /**
+     * Compile one translated graph for several instruction sets, returning
+     * the kernels in the same order. With parallel=true each instruction set
+     * after the first is compiled on its own thread. If any compilation
+     * fails, the first error is rethrown after all threads have finished.
+     */
+    static std::vector<std::shared_ptr<const ForgeKernel>> compileAll(
+        const std::shared_ptr<const ForgeGraph>& graph, const std::vector<ForgeInstructionSet>& instructionSets,
+        bool useGraphOptimizations = false, bool parallel = false)
+    {
+        std::vector<std::shared_ptr<const ForgeKernel>> kernels(instructionSets.size());
+        if (!parallel || instructionSets.size() < 2)
+        {
+            for (std::size_t i = 0; i < instructionSets.size(); ++i)
+                kernels[i] = compile(graph, instructionSets[i], useGraphOptimizations);
+            return kernels;
+        }
+
+        std::vector<std::exception_ptr> errors(instructionSets.size());
+        std::vector<std::thread> threads;
+        threads.reserve(instructionSets.size() - 1);
+        for (std::size_t i = 1; i < instructionSets.size(); ++i)
+        {
+            threads.push_back(std::thread([&, i]() {
+                try
+                {
+                    kernels[i] = compile(graph, instructionSets[i], useGraphOptimizations);
+                }
+                catch (...)
+                {
+                    errors[i] = std::current_exception();
+                }
+            }));
+        }
+        try
+        {
+            kernels[0] = compile(graph, instructionSets[0], useGraphOptimizations);
+        }
+        catch (...)
+        {
+            errors[0] = std::current_exception();
+        }
+        for (std::size_t i = 0; i < threads.size(); ++i)
+            threads[i].join();
+
+        for (std::size_t i = 0; i < errors.size(); ++i)
+        {
+            if (errors[i])
+                std::rethrow_exception(errors[i]);
+        }
+        return kernels;
+    }
+
+    /**
+     * Number of parallel evaluations per execution for an instruction set.
+     */
+    static std::size_t vectorWidthFor(ForgeInstructionSet instructionSet)
+    {
+        switch (instructionSet)
+        {
+            case FORGE_INSTRUCTION_SET_AVX2_PACKED:
+                return 4;
+#if XAD_FORGE_HAS_AVX512
+            case FORGE_INSTRUCTION_SET_AVX512_PACKED:
+                return 8;
+#endif
+            default:
+                return 1;
+        }
+    }
+
+    ~ForgeKernel()
+    {
+        cleanup();
+    }
+
+    // No copy (shared through std::shared_ptr)
+    ForgeKernel(const ForgeKernel&) = delete;
+    ForgeKernel& operator=(const ForgeKernel&) = delete;
+
+    /// The translated graph this kernel was compiled from
+    const std::shared_ptr<const ForgeGraph>& graph() const { return graph_; }
+
+    ForgeInstructionSet instructionSet() const { return instructionSet_; }
+    std::size_t vectorWidth() const { return vectorWidthFor(instructionSet_); }
+    std::size_t numInputs() const { return graph_->numInputs(); }
+    std::size_t numOutputs() const { return graph_->numOutputs(); }
+
+    const std::vector<uint32_t>& inputIds() const { return graph_->inputIds(); }
+    const std::vector<uint32_t>& outputIds() const { return graph_->outputIds(); }
+    const std::vector<uint32_t>& forwardInputIds() const { return graph_->forwardInputIds(); }
+    const std::vector<uint32_t>& forwardOutputIds() const { return graph_->forwardOutputIds(); }
+    const std::vector<uint32_t>& vjpInputIds() const { return graph_->vjpInputIds(); }
+    const std::vector<uint32_t>& vjpSeedIds() const { return graph_->vjpSeedIds(); }
+
+    const std::vector<std::size_t>& runtimeConstants() const { return graph_->runtimeConstants(); }
+    const std::vector<uint32_t>& parameterIds() const { return graph_->parameterIds(); }
+    const std::vector<uint32_t>& forwardParameterIds() const { return graph_->forwardParameterIds(); }
+    const std::vector<uint32_t>& vjpParameterIds() const { return graph_->vjpParameterIds(); }
+    const std::vector<double>& parameterDefaults() const { return graph_->parameterDefaults(); }
+    std::size_t parameterSlot(std::size_t constIndex) const { return graph_->parameterSlot(constIndex); }
+
+    /**
+     * Approximate memory footprint in bytes: the retained graph and the
+     * generated code counted by memoryUsage() plus one forward+backward
+     * execution buffer (see MemoryEstimate).
+     */
+    std::size_t estimatedBytes() const
+    {
+        // The forward+backward buffer holds a value and a gradient per node
+        return memoryUsage().total() + 2 * graph_->numNodes() * MemoryEstimate::valueBytesPerNode(vectorWidth());
+    }
+
+    /**
+     * Estimated memory of the translated graph and generated code; the
+     * graph share drops to the id mappings after releaseCompileResources().
+     */
+    MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage;
+        std::lock_guard<std::mutex> lock(forwardMutex_);
+        usage.graphBytes = graph_->estimatedBytes();
+        usage.kernelBytes =
+            graph_->numNodes() * (MemoryEstimate::codeBytesPerNode() +
+                                  (forwardKernel_ ? MemoryEstimate::forwardCodeBytesPerNode() : 0) +
+                                  (vjpKernel_ ? MemoryEstimate::codeBytesPerNode() : 0));
+        return usage;
+    }
+
+    /**
+     * Drop what is only needed to compile or to create buffers: the Forge
+     * graphs and config. The forward-only kernel, and for graphs with several
+     * outputs the VJP kernel, are compiled first if they were not yet.
+     * Buffers created before keep working; createBuffer(),
+     * createForwardBuffer() and createVjpBuffer() throw afterwards, so the
+     * kernel can no longer be shared with new backends, and a ForgeBuffer
+     * must have prepared its forward-only and VJP buffers before (see
+     * ForgeBuffer::prepareForward() and prepareVjp()).
+     *
+     * Non-const because it replaces the graph that every other member reads
+     * without locking: call it through the kernel returned by compile(),
+     * right after creating the buffers and before sharing the kernel. The
+     * Forge graphs are freed once no other kernel compiled from the same
+     * ForgeGraph holds them.
+     */
+    void releaseCompileResources()
+    {
+        forwardHandle();
+        if (graph_->hasVjp())
+            vjpHandle();
+        std::lock_guard<std::mutex> lock(forwardMutex_);
+        if (!graph_->hasHandles())
+            return;
+        graph_ = graph_->withoutHandles();
+        if (config_) { forge_config_destroy(config_); config_ = nullptr; }
+    }
+
+    /// Whether releaseCompileResources() has run
+    bool compileResourcesReleased() const { return !graph_->hasHandles(); }
+
+    /**
+     * Translation and compilation timings.
+     */
+    CompileStats compileStats() const
+    {
+        CompileStats stats;
+        stats.nodes = graph_->numNodes();
+        stats.translateMs = graph_->translationMs();
+        stats.compileMs = compileMs_;
+        std::lock_guard<std::mutex> lock(forwardMutex_);
+        stats.forwardCompileMs = forwardCompileMs_;
+        stats.vjpCompileMs = vjpCompileMs_;
+        return stats;
+    }
+
+    /**
+     * Forward+backward kernel handle.
+     */
+    ForgeKernelHandle handle() const { return kernel_; }
+
+    /**
+     * Forward-only kernel handle (no adjoint sweep), compiled on first call.
+     */
+    ForgeKernelHandle forwardHandle() const
+    {
+        std::lock_guard<std::mutex> lock(forwardMutex_);
+        if (!forwardKernel_)
+        {
+            if (!config_)
+                throw std::runtime_error("Compile resources of this kernel were released");
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            forwardKernel_ = forge_compile(graph_->forwardHandle(), config_);
+            if (!forwardKernel_)
+                throw std::runtime_error(std::string("Forge forward-only compilation failed: ") +
+                                         forge_get_last_error());
+            forwardCompileMs_ = elapsedMs(start);
+        }
+        return forwardKernel_;
+    }
+
+    /**
+     * Vector-Jacobian product kernel handle, compiled on first call. Only
+     * for graphs with several outputs (see ForgeGraph::vjpHandle()).
+     */
+    ForgeKernelHandle vjpHandle() const
+    {
+        if (!graph_->hasVjp())
+            throw std::logic_error("Graphs with at most one output have no VJP kernel");
+        std::lock_guard<std::mutex> lock(forwardMutex_);
+        if (!vjpKernel_)
+        {
+            if (!config_)
+                throw std::runtime_error("Compile resources of this kernel were released");
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            vjpKernel_ = forge_compile(graph_->vjpHandle(), config_);
+            if (!vjpKernel_)
+                throw std::runtime_error(std::string("Forge VJP compilation failed: ") + forge_get_last_error());
+            vjpCompileMs_ = elapsedMs(start);
+        }
+        return vjpKernel_;
+    }
+
+    /**
+     * Create a new execution buffer for the forward+backward kernel.
+     * The caller owns the returned handle.
+     */
+    ForgeBufferHandle createBuffer() const
+    {
+        if (!graph_->hasHandles())
+            throw std::runtime_error("Compile resources of this kernel were released");
+        ForgeBufferHandle buffer = forge_buffer_create(graph_->handle(), kernel_);
+        if (!buffer)
+            throw std::runtime_error(std::string("Forge buffer creation failed: ") + forge_get_last_error());
+        return buffer;
+    }
+
+    /**
+     * Create a new execution buffer for the forward-only kernel.
+     * The caller owns the returned handle.
+     */
+    ForgeBufferHandle createForwardBuffer() const
+    {
+        ForgeKernelHandle forwardKernel = forwardHandle();
+        if (!graph_->hasHandles())
+            throw std::runtime_error("Compile resources of this kernel were released");
+        ForgeBufferHandle buffer = forge_buffer_create(graph_->forwardHandle(), forwardKernel);
+        if (!buffer)
+            throw std::runtime_error(std::string("Forge buffer creation failed: ") + forge_get_last_error());
+        return buffer;
+    }
+
+    /**
+     * Create a new execution buffer for the VJP kernel.
+     * The caller owns the returned handle.
+     */
+    ForgeBufferHandle createVjpBuffer() const
+    {
+        ForgeKernelHandle vjpKernel = vjpHandle();
+        if (!graph_->hasHandles())
+            throw std::runtime_error("Compile resources of this kernel were released");
+        ForgeBufferHandle buffer = forge_buffer_create(graph_->vjpHandle(), vjpKernel);
+        if (!buffer)
+            throw std::runtime_error(std::string("Forge buffer creation failed: ") + forge_get_last_error());
+        return buffer;
+    }
+
+  private:
+    ForgeKernel(std::shared_ptr<const ForgeGraph> graph, ForgeInstructionSet instructionSet,
+                bool useGraphOptimizations)
+        : instructionSet_(instructionSet)
+        , graph_(std::move(graph))
+        , config_(nullptr)
+        , kernel_(nullptr)
+        , compileMs_(0.0)
+        , forwardKernel_(nullptr)
+        , forwardCompileMs_(0.0)
+        , vjpKernel_(nullptr)
+        , vjpCompileMs_(0.0)
+    {
+        try
+        {
+            build(useGraphOptimizations);
+        }
+        catch (...)
+        {
+            cleanup();
+            throw;
+        }
+    }
+
+    void build(bool useGraphOptimizations)
+    {
+        // Create config
+        config_ = useGraphOptimizations ? forge_config_create_fast() : forge_config_create_default();
+        if (!config_)
+            throw std::runtime_error("Forge config creation failed");
+
+        forge_config_set_instruction_set(config_, instructionSet_);
+
+        // Compile
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        kernel_ = forge_compile(graph_->handle(), config_);
+        if (!kernel_)
+            throw std::runtime_error(std::string("Forge compilation failed: ") + forge_get_last_error());
+        compileMs_ = elapsedMs(start);
+    }
+
+    static double elapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void cleanup()
+    {
+        if (vjpKernel_) { forge_kernel_destroy(vjpKernel_); vjpKernel_ = nullptr; }
+        if (forwardKernel_) { forge_kernel_destroy(forwardKernel_); forwardKernel_ = nullptr; }
+        if (kernel_) { forge_kernel_destroy(kernel_); kernel_ = nullptr; }
+        if (config_) { forge_config_destroy(config_); config_ = nullptr; }
+    }
+
+    ForgeInstructionSet instructionSet_;
+    std::shared_ptr<const ForgeGraph> graph_;  // without Forge graphs after releaseCompileResources()
+    ForgeConfigHandle config_;
+    ForgeKernelHandle kernel_;
+    double compileMs_;
+
+    // Forward-only variant (no adjoint sweep) and VJP variant, compiled
+    // lazily under forwardMutex_
+    mutable ForgeKernelHandle forwardKernel_;
+    mutable double forwardCompileMs_;
+    mutable ForgeKernelHandle vjpKernel_;
+    mutable double vjpCompileMs_;
+    mutable std::mutex forwardMutex_;
+};
+
+/**
+ * Execution state for one thread running a shared ForgeKernel.
+ *
+ * Owns the Forge buffer(s) holding input, intermediate and gradient values.
+ * Creating a ForgeBuffer is cheap compared to compilation; use one per
+ * thread. A ForgeBuffer itself must not be used from two threads at once.
+ *
+ * All value arrays use the kernel's vector width W: input i / output i /
+ * gradient i of lane l is at index i * W + l.
+ */
+class ForgeBuffer
+{
+  public:
+    ForgeBuffer()
+        : buffer_(nullptr)
+        , forwardKernel_(nullptr)
+        , forwardBuffer_(nullptr)
+        , vjpKernel_(nullptr)
+        , vjpBuffer_(nullptr)
+        , staleInputs_(0)
+        , accumulatedPaths_(0)
+    {
+    }
+
+    explicit ForgeBuffer(std::shared_ptr<const ForgeKernel> kernel)
+        : kernel_(std::move(kernel))
+        , buffer_(nullptr)
+        , forwardKernel_(nullptr)
+        , forwardBuffer_(nullptr)
+        , vjpKernel_(nullptr)
+        , vjpBuffer_(nullptr)
+        , staleInputs_(0)
+        , accumulatedPaths_(0)
+    {
+        if (!kernel_)
+            throw std::invalid_argument("ForgeBuffer requires a compiled kernel");
+        buffer_ = kernel_->createBuffer();
+        lanes_.resize(kernel_->vectorWidth());
+
+        setConstants(kernel_->parameterDefaults());
+    }
+
+    ~ForgeBuffer()
+    {
+        cleanup();
+    }
+
+    ForgeBuffer(ForgeBuffer&& other) noexcept
+        : kernel_(std::move(other.kernel_))
+        , buffer_(other.buffer_)
+        , forwardKernel_(other.forwardKernel_)
+        , forwardBuffer_(other.forwardBuffer_)
+        , vjpKernel_(other.vjpKernel_)
+        , vjpBuffer_(other.vjpBuffer_)
+        , lanes_(std::move(other.lanes_))
+        , constants_(std::move(other.constants_))
+        , outputSums_(std::move(other.outputSums_))
+        , gradientSums_(std::move(other.gradientSums_))
+        , gradientScratch_(std::move(other.gradientScratch_))
+        , staleInputs_(other.staleInputs_)
+        , accumulatedPaths_(other.accumulatedPaths_)
+    {
+        other.buffer_ = nullptr;
+        other.forwardKernel_ = nullptr;
+        other.forwardBuffer_ = nullptr;
+        other.vjpKernel_ = nullptr;
+        other.vjpBuffer_ = nullptr;
+    }
+
+    ForgeBuffer& operator=(ForgeBuffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            cleanup();
+            kernel_ = std::move(other.kernel_);
+            buffer_ = other.buffer_;
+            forwardKernel_ = other.forwardKernel_;
+            forwardBuffer_ = other.forwardBuffer_;
+            vjpKernel_ = other.vjpKernel_;
+            vjpBuffer_ = other.vjpBuffer_;
+            lanes_ = std::move(other.lanes_);
+            constants_ = std::move(other.constants_);
+            outputSums_ = std::move(other.outputSums_);
+            gradientSums_ = std::move(other.gradientSums_);
+            gradientScratch_ = std::move(other.gradientScratch_);
+            staleInputs_ = other.staleInputs_;
+            accumulatedPaths_ = other.accumulatedPaths_;
+            other.buffer_ = nullptr;
+            other.forwardKernel_ = nullptr;
+            other.forwardBuffer_ = nullptr;
+            other.vjpKernel_ = nullptr;
+            other.vjpBuffer_ = nullptr;
+        }
+        return *this;
+    }
+
+    // No copy
+    ForgeBuffer(const ForgeBuffer&) = delete;
+    ForgeBuffer& operator=(const ForgeBuffer&) = delete;
+
+    bool valid() const { return buffer_ != nullptr; }
+    const std::shared_ptr<const ForgeKernel>& kernel() const { return kernel_; }
+    std::size_t vectorWidth() const { return lanes_.size(); }
+
+    /**
+     * Create the forward-only buffer now rather than on the first forward(),
+     * e.g. before the kernel's compile resources are released.
+     */
+    void prepareForward() { ensureForwardBuffer(); }
+
+    /**
+     * Create the VJP buffer now rather than on the first forwardAndBackward()
+     * with output adjoints. Does nothing for graphs with at most one output,
+     * which need no VJP buffer.
+     */
+    void prepareVjp()
+    {
+        if (kernel_ && kernel_->graph()->hasVjp())
+            ensureVjpBuffer();
+    }
+
+    /**
+     * Estimated bytes of the Forge buffers and host-side accumulators.
+     */
+    std::size_t estimatedBytes() const
+    {
+        if (!kernel_)
+            return 0;
+        // The forward+backward buffer holds a value and a gradient per node
+        const std::size_t nodeBytes = kernel_->graph()->numNodes() * MemoryEstimate::valueBytesPerNode(vectorWidth());
+        return 2 * nodeBytes + (forwardBuffer_ ? nodeBytes : 0) + (vjpBuffer_ ? 2 * nodeBytes : 0) +
+               sizeof(double) * (lanes_.size() + outputSums_.size() + gradientSums_.size() + gradientScratch_.size());
+    }
+
+    /**
+     * Set W values for an input (one per lane).
+     */
+    void setInput(std::size_t inputIndex, const double* values)
+    {
+        if (!kernel_ || inputIndex >= kernel_->numInputs())
+            throw std::runtime_error("Input index out of range");
+        refreshInputs(staleInputs_);
+        forge_buffer_set_lanes(buffer_, kernel_->inputIds()[inputIndex], values);
+        if (forwardBuffer_)
+            forge_buffer_set_lanes(forwardBuffer_, kernel_->forwardInputIds()[inputIndex], values);
+        if (vjpBuffer_)
+            forge_buffer_set_lanes(vjpBuffer_, kernel_->vjpInputIds()[inputIndex], values);
+    }
+
+    /**
+     * Set all inputs at once: values[i * W + l] is input i in lane l, the
+     * same layout as the gradients of forwardAndBackward().
+     */
+    void setInputs(const double* values)
+    {
+        if (!kernel_)
+            throw std::runtime_error("Backend not compiled");
+        const std::vector<uint32_t>& inputIds = kernel_->inputIds();
+        const std::size_t width = vectorWidth();
+        for (std::size_t i = 0; i < inputIds.size(); ++i)
+            forge_buffer_set_lanes(buffer_, inputIds[i], values + i * width);
+        if (forwardBuffer_)
+        {
+            const std::vector<uint32_t>& forwardInputIds = kernel_->forwardInputIds();
+            for (std::size_t i = 0; i < forwardInputIds.size(); ++i)
+                forge_buffer_set_lanes(forwardBuffer_, forwardInputIds[i], values + i * width);
+        }
+        if (vjpBuffer_)
+        {
+            const std::vector<uint32_t>& vjpInputIds = kernel_->vjpInputIds();
+            for (std::size_t i = 0; i < vjpInputIds.size(); ++i)
+                forge_buffer_set_lanes(vjpBuffer_, vjpInputIds[i], values + i * width);
+        }
+        staleInputs_ = 0;
+    }
+
+    /**
+     * Set the value of a runtime constant (a const_pool index passed to
+     * ForgeKernel::compile() as runtime constant) for all lanes. Takes effect
+     * from the next execution; nothing is recompiled.
+     */
+    void setConstant(std::size_t constIndex, double value)
+    {
+        if (!kernel_)
+            throw std::runtime_error("Backend not compiled");
+        const std::size_t slot = kernel_->parameterSlot(constIndex);
+        if (slot == kernel_->runtimeConstants().size())
+            throw std::invalid_argument("Constant is not a runtime constant of this kernel");
+
+        setConstantSlot(slot, value);
+    }
+
+    /**
+     * Current values of the runtime constants, in kernel()->runtimeConstants()
+     * order. A new buffer starts at kernel()->parameterDefaults(), the values
+     * recorded in the graph the kernel was compiled from; pass these to
+     * setConstants() of another buffer on the same kernel to carry them over.
+     */
+    const std::vector<double>& constants() const { return constants_; }
+
+    /**
+     * Set all runtime constants, values in kernel()->runtimeConstants() order.
+     */
+    void setConstants(const std::vector<double>& values)
+    {
+        if (!kernel_)
+            throw std::runtime_error("Backend not compiled");
+        if (values.size() != kernel_->runtimeConstants().size())
+            throw std::invalid_argument("Expected one value per runtime constant");
+        constants_.resize(values.size());
+        for (std::size_t slot = 0; slot < values.size(); ++slot)
+            setConstantSlot(slot, values[slot]);
+    }
+
+    /**
+     * Set every runtime constant to its value in jitGraph's const_pool, e.g.
+     * after a KernelCache returned a kernel compiled from another graph.
+     */
+    void loadConstants(const xad::JITGraph& jitGraph)
+    {
+        if (!kernel_)
+            throw std::runtime_error("Backend not compiled");
+        const std::vector<std::size_t>& constants = kernel_->runtimeConstants();
+        for (std::size_t slot = 0; slot < constants.size(); ++slot)
+            setConstant(constants[slot], jitGraph.const_pool[constants[slot]]);
+    }
+
+    /**
+     * Execute forward pass only, using the forward-only kernel.
+     */
+    void forward(double* outputs)
+    {
+        ensureForwardBuffer();
+        refreshInputs(ForwardInputs);
+
+        ForgeError err = forge_execute(forwardKernel_, forwardBuffer_);
+        if (err != FORGE_SUCCESS)
+            throw std::runtime_error(std::string("Forge execution failed: ") + forge_get_last_error());
+
+        const std::vector<uint32_t>& outputIds = kernel_->forwardOutputIds();
+        const std::size_t width = vectorWidth();
+        for (std::size_t i = 0; i < outputIds.size(); ++i)
+        {
+            forge_buffer_get_lanes(forwardBuffer_, outputIds[i], outputs + i * width);
+        }
+    }
+
+    /**
+     * Execute forward + backward in one call.
+     */
+    void forwardAndBackward(double* outputs, double* inputGradients)
+    {
+        if (!buffer_)
+            throw std::runtime_error("Backend not compiled");
+
+        // Forge's backward sweep accumulates into every adjoint, so they must
+        // start at zero; the C API can only clear the whole gradient area.
+        // forward() runs a kernel without adjoints and never clears.
+        refreshInputs(MainInputs);
+        forge_buffer_clear_gradients(buffer_);
+        ForgeError err = forge_execute(kernel_->handle(), buffer_);
+        if (err != FORGE_SUCCESS)
+            throw std::runtime_error(std::string("Forge execution failed: ") + forge_get_last_error());
+
+        const std::vector<uint32_t>& outputIds = kernel_->outputIds();
+        const std::vector<uint32_t>& inputIds = kernel_->inputIds();
+        const std::size_t width = vectorWidth();
+
+        // Get outputs
+        for (std::size_t i = 0; i < outputIds.size(); ++i)
+        {
+            forge_buffer_get_lanes(buffer_, outputIds[i], outputs + i * width);
+        }
+
+        // Get all input gradients in one call; Forge writes them id-major,
+        // which is the layout of inputGradients
+        if (!inputIds.empty())
+            forge_buffer_get_gradient_lanes(buffer_, inputIds.data(), inputIds.size(), inputGradients);
+    }
+
+    /**
+     * Execute forward + backward with caller-supplied output adjoints, i.e.
+     * a vector-Jacobian product: inputGradients[i * W + l] is
+     * sum_k outputAdjoints[k * W + l] * d output_k / d input_i in lane l.
+     *
+     * With several outputs this runs the kernel's VJP variant (compiled on
+     * first use), which takes the adjoints as extra inputs, so a weighted
+     * sum over all outputs costs one backward sweep. With one output the
+     * plain gradient is scaled by the adjoint.
+     */
+    void forwardAndBackward(double* outputs, const double* outputAdjoints, double* inputGradients)
+    {
+        if (!buffer_)
+            throw std::runtime_error("Backend not compiled");
+        const std::size_t width = vectorWidth();
+        if (!kernel_->graph()->hasVjp())
+        {
+            // One output: scale its gradient by the adjoint on the host.
+            // Without outputs the gradients are all zero and stay so.
+            forwardAndBackward(outputs, inputGradients);
+            if (kernel_->numOutputs() == 0)
+                return;
+            for (std::size_t i = 0; i < kernel_->numInputs(); ++i)
+            {
+                for (std::size_t lane = 0; lane < width; ++lane)
+                    inputGradients[i * width + lane] *= outputAdjoints[lane];
+            }
+            return;
+        }
+
+        ensureVjpBuffer();
+        refreshInputs(VjpInputs);
+        const std::vector<uint32_t>& seedIds = kernel_->vjpSeedIds();
+        const std::vector<uint32_t>& inputIds = kernel_->vjpInputIds();
+        for (std::size_t k = 0; k < seedIds.size(); ++k)
+            forge_buffer_set_lanes(vjpBuffer_, seedIds[k], outputAdjoints + k * width);
+
+        forge_buffer_clear_gradients(vjpBuffer_);
+        ForgeError err = forge_execute(vjpKernel_, vjpBuffer_);
+        if (err != FORGE_SUCCESS)
+            throw std::runtime_error(std::string("Forge execution failed: ") + forge_get_last_error());
+
+        // The gradient of seed k is output k
+        forge_buffer_get_gradient_lanes(vjpBuffer_, seedIds.data(), seedIds.size(), outputs);
+        if (!inputIds.empty())
+            forge_buffer_get_gradient_lanes(vjpBuffer_, inputIds.data(), inputIds.size(), inputGradients);
+    }
+
+    /**
+     * Evaluate numPaths independent paths in one call.
+     *
+     * All arrays are structure-of-arrays, i.e. the value of input i for path p
+     * is inputsSoA[i * numPaths + p], and likewise for outputsSoA (numOutputs()
+     * rows) and gradientsSoA (numInputs() rows). Paths are processed in batches
+     * of the vector width; numPaths need not be a multiple of it. In the final
+     * partial batch the unused lanes repeat the last path and their results are
+     * discarded.
+     *
+     * If gradientsSoA is null, only the forward-only kernel is run.
+     * This overwrites any input values previously set with setInput(): all
+     * other calls afterwards see the inputs of the final batch.
+     */
+    void evaluate(std::size_t numPaths, const double* inputsSoA, double* outputsSoA,
+                  double* gradientsSoA = nullptr)
+    {
+        if (!buffer_)
+            throw std::runtime_error("Backend not compiled");
+
+        const bool withGradients = gradientsSoA != nullptr;
+        if (!withGradients)
+            ensureForwardBuffer();
+
+        ForgeKernelHandle kernel = withGradients ? kernel_->handle() : forwardKernel_;
+        ForgeBufferHandle buffer = withGradients ? buffer_ : forwardBuffer_;
+        const std::vector<uint32_t>& inputIds = withGradients ? kernel_->inputIds() : kernel_->forwardInputIds();
+        const std::vector<uint32_t>& outputIds = withGradients ? kernel_->outputIds() : kernel_->forwardOutputIds();
+
+        const std::size_t width = vectorWidth();
+        double* lanes = lanes_.data();
+        for (std::size_t path = 0; path < numPaths; path += width)
+        {
+            const std::size_t active = std::min(width, numPaths - path);
+            const bool fullBatch = active == width;
+
+            setInputBatch(buffer, inputIds, inputsSoA + path, numPaths, active);
+            inputsWrittenTo(withGradients ? MainInputs : ForwardInputs);
+
+            if (withGradients)
+                forge_buffer_clear_gradients(buffer);
+            ForgeError err = forge_execute(kernel, buffer);
+            if (err != FORGE_SUCCESS)
+                throw std::runtime_error(std::string("Forge execution failed: ") + forge_get_last_error());
+
+            for (std::size_t i = 0; i < outputIds.size(); ++i)
+            {
+                double* dst = outputsSoA + i * numPaths + path;
+                if (fullBatch)
+                {
+                    forge_buffer_get_lanes(buffer, outputIds[i], dst);
+                    continue;
+                }
+                forge_buffer_get_lanes(buffer, outputIds[i], lanes);
+                std::copy(lanes, lanes + active, dst);
+            }
+
+            if (!withGradients)
+                continue;
+
+            // One gather for all inputs, then scatter into the SoA rows
+            if (inputIds.empty())
+                continue;
+            gradientScratch_.resize(inputIds.size() * width);
+            forge_buffer_get_gradient_lanes(buffer, inputIds.data(), inputIds.size(), gradientScratch_.data());
+            for (std::size_t i = 0; i < inputIds.size(); ++i)
+            {
+                const double* src = &gradientScratch_[i * width];
+                std::copy(src, src + active, gradientsSoA + i * numPaths + path);
+            }
+        }
+    }
+
+    // =========================================================================
+    // Accumulation across paths
+    // =========================================================================
+
+    /**
+     * Execute forward + backward and add the outputs and input gradients of
+     * the first activeLanes lanes to running sums, instead of returning them.
+     *
+     * Sums are kept per lane and only reduced across lanes when read, and
+     * all input gradients are gathered in a single C API call.
+     */
+    void forwardAndAccumulate(std::size_t activeLanes)
+    {
+        if (!buffer_)
+            throw std::runtime_error("Backend not compiled");
+
+        refreshInputs(MainInputs);
+        forge_buffer_clear_gradients(buffer_);
+        ForgeError err = forge_execute(kernel_->handle(), buffer_);
+        if (err != FORGE_SUCCESS)
+            throw std::runtime_error(std::string("Forge execution failed: ") + forge_get_last_error());
+
+        addToAccumulators(std::min(activeLanes, vectorWidth()));
+    }
+
+    /**
+     * Accumulate numPaths paths given in SoA layout (inputsSoA[i * numPaths + p]).
+     * The unused lanes of a final partial batch are not accumulated. Like
+     * evaluate(), this leaves the inputs of the final batch set.
+     */
+    void accumulate(std::size_t numPaths, const double* inputsSoA)
+    {
+        if (!buffer_)
+            throw std::runtime_error("Backend not compiled");
+
+        const std::vector<uint32_t>& inputIds = kernel_->inputIds();
+        const std::size_t width = vectorWidth();
+        for (std::size_t path = 0; path < numPaths; path += width)
+        {
+            const std::size_t active = std::min(width, numPaths - path);
+            setInputBatch(buffer_, inputIds, inputsSoA + path, numPaths, active);
+            inputsWrittenTo(MainInputs);
+            forwardAndAccumulate(active);
+        }
+    }
+
+    /**
+     * Reset the running sums to zero.
+     */
+    void clearAccumulators()
+    {
+        std::fill(outputSums_.begin(), outputSums_.end(), 0.0);
+        std::fill(gradientSums_.begin(), gradientSums_.end(), 0.0);
+        accumulatedPaths_ = 0;
+    }
+
+    /// Number of paths (lanes) accumulated since the last clearAccumulators()
+    std::size_t accumulatedPaths() const { return accumulatedPaths_; }
+
+    /**
+     * Sum of each output over all accumulated paths (numOutputs() values).
+     */
+    void getAccumulatedOutputs(double* sums) const
+    {
+        reduceLanes(outputSums_, kernel_ ? kernel_->numOutputs() : 0, sums);
+    }
+
+    /**
+     * Sum of each input gradient over all accumulated paths (numInputs() values).
+     */
+    void getAccumulatedGradients(double* sums) const
+    {
+        reduceLanes(gradientSums_, kernel_ ? kernel_->numInputs() : 0, sums);
+    }
+
+    int getVectorWidth() const
+    {
+        return buffer_ ? forge_buffer_get_vector_width(buffer_) : 0;
+    }
+
+    std::size_t getBufferIndex(uint32_t nodeId) const
+    {
+        return buffer_ ? forge_buffer_get_index(buffer_, nodeId) : SIZE_MAX;
+    }
+
+  private:
+    /**
+     * Set one batch of inputs from SoA arrays (row stride numPaths, already
+     * offset to the batch's first path). Full batches are contiguous in SoA
+     * layout and go straight to the buffer; in a partial batch the unused
+     * lanes repeat the last active path.
+     */
+    void setInputBatch(ForgeBufferHandle buffer, const std::vector<uint32_t>& inputIds, const double* inputsSoA,
+                       std::size_t numPaths, std::size_t active)
+    {
+        const std::size_t width = vectorWidth();
+        for (std::size_t i = 0; i < inputIds.size(); ++i)
+        {
+            const double* src = inputsSoA + i * numPaths;
+            if (active == width)
+            {
+                forge_buffer_set_lanes(buffer, inputIds[i], src);
+                continue;
+            }
+            for (std::size_t lane = 0; lane < width; ++lane)
+                lanes_[lane] = src[lane < active ? lane : active - 1];
+            forge_buffer_set_lanes(buffer, inputIds[i], lanes_.data());
+        }
+    }
+
+    /**
+     * Create the forward-only buffer on first use.
+     * Input values already set on the forward+backward buffer are carried over.
+     */
+    void ensureForwardBuffer()
+    {
+        if (!buffer_)
+            throw std::runtime_error("Backend not compiled");
+        if (forwardBuffer_)
+            return;
+
+        refreshInputs(MainInputs);  // the new buffer copies its inputs from buffer_
+        forwardKernel_ = kernel_->forwardHandle();
+        forwardBuffer_ = kernel_->createForwardBuffer();
+
+        const std::vector<uint32_t>& inputIds = kernel_->inputIds();
+        const std::vector<uint32_t>& forwardInputIds = kernel_->forwardInputIds();
+        for (std::size_t i = 0; i < inputIds.size(); ++i)
+        {
+            forge_buffer_get_lanes(buffer_, inputIds[i], lanes_.data());
+            forge_buffer_set_lanes(forwardBuffer_, forwardInputIds[i], lanes_.data());
+        }
+
+        const std::vector<uint32_t>& parameterIds = kernel_->parameterIds();
+        const std::vector<uint32_t>& forwardParameterIds = kernel_->forwardParameterIds();
+        for (std::size_t slot = 0; slot < parameterIds.size(); ++slot)
+        {
+            forge_buffer_get_lanes(buffer_, parameterIds[slot], lanes_.data());
+            forge_buffer_set_lanes(forwardBuffer_, forwardParameterIds[slot], lanes_.data());
+        }
+    }
+
+    /**
+     * Create the VJP buffer on first use, carrying over inputs and runtime
+     * constants like ensureForwardBuffer().
+     */
+    void ensureVjpBuffer()
+    {
+        if (vjpBuffer_)
+            return;
+
+        refreshInputs(MainInputs);  // the new buffer copies its inputs from buffer_
+        vjpKernel_ = kernel_->vjpHandle();
+        vjpBuffer_ = kernel_->createVjpBuffer();
+
+        const std::vector<uint32_t>& inputIds = kernel_->inputIds();
+        const std::vector<uint32_t>& vjpInputIds = kernel_->vjpInputIds();
+        for (std::size_t i = 0; i < inputIds.size(); ++i)
+        {
+            forge_buffer_get_lanes(buffer_, inputIds[i], lanes_.data());
+            forge_buffer_set_lanes(vjpBuffer_, vjpInputIds[i], lanes_.data());
+        }
+
+        const std::vector<uint32_t>& parameterIds = kernel_->parameterIds();
+        const std::vector<uint32_t>& vjpParameterIds = kernel_->vjpParameterIds();
+        for (std::size_t slot = 0; slot < parameterIds.size(); ++slot)
+        {
+            forge_buffer_get_lanes(buffer_, parameterIds[slot], lanes_.data());
+            forge_buffer_set_lanes(vjpBuffer_, vjpParameterIds[slot], lanes_.data());
+        }
+    }
+
+    /// Buffers holding input values, for staleInputs_
+    enum InputBuffer
+    {
+        MainInputs = 1,
+        ForwardInputs = 2,
+        VjpInputs = 4
+    };
+
+    /**
+     * Record that a batch call set all inputs of the buffer(s) in written
+     * only, so every other existing buffer now holds outdated inputs.
+     */
+    void inputsWrittenTo(unsigned written)
+    {
+        unsigned existing = MainInputs;
+        if (forwardBuffer_)
+            existing |= ForwardInputs;
+        if (vjpBuffer_)
+            existing |= VjpInputs;
+        staleInputs_ = existing & ~written;
+    }
+
+    /**
+     * Copy the current inputs into each buffer in targets that holds
+     * outdated ones, from a buffer that is up to date.
+     */
+    void refreshInputs(unsigned targets)
+    {
+        targets &= staleInputs_;
+        if (!targets)
+            return;
+
+        const unsigned source = !(staleInputs_ & MainInputs)                     ? MainInputs
+                                : forwardBuffer_ && !(staleInputs_ & ForwardInputs) ? ForwardInputs
+                                                                                    : VjpInputs;
+        const InputBuffer all[] = {MainInputs, ForwardInputs, VjpInputs};
+        for (InputBuffer target : all)
+        {
+            if (!(targets & target))
+                continue;
+            const std::vector<uint32_t>& from = inputIdsOf(source);
+            const std::vector<uint32_t>& to = inputIdsOf(target);
+            for (std::size_t i = 0; i < from.size(); ++i)
+            {
+                forge_buffer_get_lanes(bufferOf(source), from[i], lanes_.data());
+                forge_buffer_set_lanes(bufferOf(target), to[i], lanes_.data());
+            }
+            staleInputs_ &= ~static_cast<unsigned>(target);
+        }
+    }
+
+    ForgeBufferHandle bufferOf(unsigned which) const
+    {
+        return which == MainInputs ? buffer_ : which == ForwardInputs ? forwardBuffer_ : vjpBuffer_;
+    }
+
+    const std::vector<uint32_t>& inputIdsOf(unsigned which) const
+    {
+        return which == MainInputs      ? kernel_->inputIds()
+               : which == ForwardInputs ? kernel_->forwardInputIds()
+                                        : kernel_->vjpInputIds();
+    }
+
+    void setConstantSlot(std::size_t slot, double value)
+    {
+        constants_[slot] = value;
+        std::fill(lanes_.begin(), lanes_.end(), value);
+        forge_buffer_set_lanes(buffer_, kernel_->parameterIds()[slot], lanes_.data());
+        if (forwardBuffer_)
+            forge_buffer_set_lanes(forwardBuffer_, kernel_->forwardParameterIds()[slot], lanes_.data());
+        if (vjpBuffer_)
+            forge_buffer_set_lanes(vjpBuffer_, kernel_->vjpParameterIds()[slot], lanes_.data());
+    }
+
+    void addToAccumulators(std::size_t activeLanes)
+    {
+        const std::vector<uint32_t>& outputIds = kernel_->outputIds();
+        const std::vector<uint32_t>& inputIds = kernel_->inputIds();
+        const std::size_t width = vectorWidth();
+
+        if (outputSums_.empty() && gradientSums_.empty())
+        {
+            outputSums_.assign(outputIds.size() * width, 0.0);
+            gradientSums_.assign(inputIds.size() * width, 0.0);
+            gradientScratch_.resize(inputIds.size() * width);
+        }
+
+        for (std::size_t i = 0; i < outputIds.size(); ++i)
+        {
+            forge_buffer_get_lanes(buffer_, outputIds[i], lanes_.data());
+            for (std::size_t lane = 0; lane < activeLanes; ++lane)
+                outputSums_[i * width + lane] += lanes_[lane];
+        }
+
+        if (!inputIds.empty())
+            forge_buffer_get_gradient_lanes(buffer_, inputIds.data(), inputIds.size(), gradientScratch_.data());
+        for (std::size_t i = 0; i < inputIds.size(); ++i)
+        {
+            for (std::size_t lane = 0; lane < activeLanes; ++lane)
+                gradientSums_[i * width + lane] += gradientScratch_[i * width + lane];
+        }
+
+        accumulatedPaths_ += activeLanes;
+    }
+
+    void reduceLanes(const std::vector<double>& laneSums, std::size_t count, double* sums) const
+    {
+        const std::size_t width = vectorWidth();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            double sum = 0.0;
+            for (std::size_t lane = 0; lane < width && i * width + lane < laneSums.size(); ++lane)
+                sum += laneSums[i * width + lane];
+            sums[i] = sum;
+        }
+    }
+
+    void cleanup()
+    {
+        if (vjpBuffer_) { forge_buffer_destroy(vjpBuffer_); vjpBuffer_ = nullptr; }
+        if (forwardBuffer_) { forge_buffer_destroy(forwardBuffer_); forwardBuffer_ = nullptr; }
+        if (buffer_) { forge_buffer_destroy(buffer_); buffer_ = nullptr; }
+        forwardKernel_ = nullptr;
+        vjpKernel_ = nullptr;
+    }
+
+    std::shared_ptr<const ForgeKernel> kernel_;
+    ForgeBufferHandle buffer_;
+    ForgeKernelHandle forwardKernel_;  // owned by kernel_, cached to avoid locking per call
+    ForgeBufferHandle forwardBuffer_;
+    ForgeKernelHandle vjpKernel_;  // owned by kernel_, like forwardKernel_
+    ForgeBufferHandle vjpBuffer_;
+    std::vector<double> lanes_;  // scratch for one input/output across all lanes
+    std::vector<double> constants_;  // runtime constant values, per parameter slot
+
+    // Running per-lane sums for forwardAndAccumulate(), allocated on first use;
+    // gradientScratch_ also receives the batched gradient gather of evaluate()
+    std::vector<double> outputSums_;
+    std::vector<double> gradientSums_;
+    std::vector<double> gradientScratch_;
+
+    // InputBuffer bits of the buffers whose inputs are outdated: batch calls
+    // (evaluate(), accumulate()) write one buffer only, and the others are
+    // brought up to date before they next execute or take a single input
+    unsigned staleInputs_;
+    std::size_t accumulatedPaths_;
+};
+
+}  // namespace forge
+}  // namespace xad
@@ -0,0 +1,198 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  GraphHash - Stable content hash of an xad::JITGraph compilation
+//
+//  This file is part of xad-forge, providing Forge JIT compilation
+//  as a backend for XAD automatic differentiation.
+//
+//  Two compilations that produce the same kernel hash equally: the hash
+//  covers every node (op, operands, immediate, flags), the constant pool,
+//  the input/output ids, the instruction set and the optimization flag.
+//  Constants compiled as runtime parameters are hashed by index only, so
+//  graphs that differ just in those values share a key.
+//  It is computed byte-wise in a fixed order, so it is identical across
+//  processes and machines and can be used as a cache key.
+//
+//  Copyright (c) 2025 The xad-forge Authors
+//  https://github.com/da-roth/xad-forge
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <XAD/JITGraph.hpp>
+
+// Forge C API - stable ABI
+#include <forge_c_api.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace xad
+{
+namespace forge
+{
+
+/**
+ * 128-bit hash of a graph compilation (graph + instruction set + options).
+ *
+ * hi and lo are two independent 64-bit hashes of the same data: FNV-1a
+ * over its bytes, and a multiply-rotate hash over its 64-bit words with
+ * different constants. Each is finished with the MurmurHash3 finalizer.
+ * This is not a cryptographic hash, and distinct graphs can collide, so a
+ * cache must not treat equal hashes as proof of equal graphs (KernelCache
+ * compares the graphs on every hit).
+ */
+struct GraphHash
+{
+    uint64_t hi;
+    uint64_t lo;
+
+    bool operator==(const GraphHash& other) const { return hi == other.hi && lo == other.lo; }
+    bool operator!=(const GraphHash& other) const { return !(*this == other); }
+    bool operator<(const GraphHash& other) const { return hi != other.hi ? hi < other.hi : lo < other.lo; }
+
+    /// 32 lowercase hex digits, e.g. for use as a file name
+    std::string toString() const
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string s(32, '0');
+        for (int i = 0; i < 16; ++i)
+        {
+            s[15 - i] = digits[(hi >> (4 * i)) & 0xF];
+            s[31 - i] = digits[(lo >> (4 * i)) & 0xF];
+        }
+        return s;
+    }
+
+    /**
+     * Hash a graph as it would be compiled by ForgeKernel::compile().
+     * runtimeConstants must be sorted and free of duplicates.
+     */
+    static GraphHash compute(const xad::JITGraph& graph, ForgeInstructionSet instructionSet,
+                             bool useGraphOptimizations,
+                             const std::vector<std::size_t>& runtimeConstants = std::vector<std::size_t>())
+    {
+        Hasher h;
+        h.add(kFormatVersion);
+        h.add(static_cast<uint32_t>(instructionSet));
+        h.add(static_cast<uint32_t>(useGraphOptimizations ? 1 : 0));
+
+        h.add(static_cast<uint64_t>(graph.nodeCount()));
+        for (std::size_t i = 0; i < graph.nodeCount(); ++i)
+        {
+            const auto& node = graph.nodes[i];
+            h.add(static_cast<uint32_t>(node.op));
+            h.add(static_cast<uint32_t>(node.a));
+            h.add(static_cast<uint32_t>(node.b));
+            h.add(static_cast<uint32_t>(node.c));
+            h.add(static_cast<double>(node.imm));
+            h.add(static_cast<uint32_t>(node.flags));
+        }
+
+        h.add(static_cast<uint64_t>(graph.const_pool.size()));
+        std::size_t nextParameter = 0;
+        for (std::size_t i = 0; i < graph.const_pool.size(); ++i)
+        {
+            if (nextParameter < runtimeConstants.size() && runtimeConstants[nextParameter] == i)
+            {
+                // Runtime parameter: only its position matters
+                h.add(static_cast<uint32_t>(0xFFFFFFFFu));
+                ++nextParameter;
+                continue;
+            }
+            h.add(static_cast<double>(graph.const_pool[i]));
+        }
+
+        h.add(static_cast<uint64_t>(graph.input_ids.size()));
+        for (std::size_t i = 0; i < graph.input_ids.size(); ++i)
+            h.add(static_cast<uint32_t>(graph.input_ids[i]));
+
+        h.add(static_cast<uint64_t>(graph.output_ids.size()));
+        for (std::size_t i = 0; i < graph.output_ids.size(); ++i)
+            h.add(static_cast<uint32_t>(graph.output_ids[i]));
+
+        GraphHash result;
+        result.hi = Hasher::finalize(h.hi ^ h.words);
+        result.lo = Hasher::finalize(h.lo ^ (h.words * 0x9E3779B97F4A7C15ULL));
+        return result;
+    }
+
+  private:
+    /// Bump when the hashed fields change, so stale cache keys stop matching
+    static const uint32_t kFormatVersion = 3;
+
+    struct Hasher
+    {
+        uint64_t hi;
+        uint64_t lo;
+        uint64_t words;  // number of words added
+
+        Hasher()
+            : hi(14695981039346656037ULL)  // FNV-1a 64-bit offset basis
+            , lo(0x27D4EB2F165667C5ULL)
+            , words(0)
+        {
+        }
+
+        void addWord(uint64_t word)
+        {
+            // FNV-1a over the bytes, in fixed little-endian order
+            const uint64_t prime = 1099511628211ULL;
+            for (int i = 0; i < 8; ++i)
+                hi = (hi ^ static_cast<uint8_t>(word >> (8 * i))) * prime;
+
+            // Multiply-rotate over the whole word
+            lo ^= word * 0xC2B2AE3D27D4EB4FULL;
+            lo = (lo << 31) | (lo >> 33);
+            lo *= 0x9E3779B97F4A7C15ULL;
+
+            ++words;
+        }
+
+        /// MurmurHash3 fmix64: every input bit affects every output bit
+        static uint64_t finalize(uint64_t k)
+        {
+            k ^= k >> 33;
+            k *= 0xFF51AFD7ED558CCDULL;
+            k ^= k >> 33;
+            k *= 0xC4CEB9FE1A85EC53ULL;
+            k ^= k >> 33;
+            return k;
+        }
+
+        // Values are hashed as numbers, independent of the host byte order
+        void add(uint32_t value) { addWord(value); }
+        void add(uint64_t value) { addWord(value); }
+
+        // Exact bits, so e.g. 0.0 and -0.0 are distinct
+        void add(double value)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            add(bits);
+        }
+    };
+};
+
+}  // namespace forge
+}  // namespace xad
@@ -0,0 +1,422 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  GraphOptimizer - Dead-code, common-subexpression and constant folding
+//                   pre-pass on xad::JITGraph
+//
+//  This file is part of xad-forge, providing Forge JIT compilation
+//  as a backend for XAD automatic differentiation.
+//
+//  XAD records every operation that was executed on active values, so a
+//  graph often contains nodes that reach no output, repeated subexpressions
+//  (e.g. the same discount factor computed per cash flow) and arithmetic on
+//  constants only. Removing them before translation shrinks the graph that
+//  Forge has to compile and execute, independent of Forge's own passes.
+//
+//  Copyright (c) 2025 The xad-forge Authors
+//  https://github.com/da-roth/xad-forge
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <XAD/JITGraph.hpp>
+#include <XAD/JITGraphInterpreter.hpp>
+
+// Forge C API - stable ABI
+#include <forge_c_api.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace xad
+{
+namespace forge
+{
+
+/**
+ * Passes run by GraphOptimizer::optimize().
+ */
+struct GraphOptimizationOptions
+{
+    GraphOptimizationOptions()
+        : eliminateDeadCode(true)
+        , eliminateCommonSubexpressions(true)
+        , foldConstants(true)
+    {
+    }
+
+    bool eliminateDeadCode;              ///< drop nodes that reach no output
+    bool eliminateCommonSubexpressions;  ///< merge identical nodes with identical operands
+    bool foldConstants;                  ///< evaluate nodes that depend on constants only
+
+    /// const_pool indices compiled as runtime parameters; never folded
+    std::vector<std::size_t> runtimeConstants;
+};
+
+/**
+ * Node counts before and after GraphOptimizer::optimize().
+ * nodesBefore - nodesAfter == deadNodesRemoved + duplicatesMerged.
+ */
+struct GraphOptimizationStats
+{
+    GraphOptimizationStats()
+        : nodesBefore(0)
+        , nodesAfter(0)
+        , constantsFolded(0)
+        , deadNodesRemoved(0)
+        , duplicatesMerged(0)
+    {
+    }
+
+    std::size_t nodesBefore;
+    std::size_t nodesAfter;
+    std::size_t constantsFolded;   ///< nodes replaced by a constant
+    std::size_t deadNodesRemoved;  ///< includes constant-only intermediates made dead by folding
+    std::size_t duplicatesMerged;
+};
+
+/**
+ * Pre-pass producing a smaller, equivalent xad::JITGraph.
+ *
+ * Inputs and their order are always kept, so the optimized graph has the
+ * same inputs and outputs as the original. Existing const_pool indices are
+ * unchanged (folded values are appended), so runtime constant indices stay
+ * valid. Constant folding evaluates the constant-only nodes with XAD's
+ * graph interpreter, so it supports exactly the operations XAD records.
+ *
+ * Usage:
+ *   xad::forge::GraphOptimizationStats stats;
+ *   xad::JITGraph optimized = xad::forge::GraphOptimizer::optimize(jit.getGraph(),
+ *       xad::forge::GraphOptimizationOptions(), &stats);
+ *   backend.compile(optimized);
+ */
+class GraphOptimizer
+{
+  public:
+    static xad::JITGraph optimize(const xad::JITGraph& graph,
+                                  const GraphOptimizationOptions& options = GraphOptimizationOptions(),
+                                  GraphOptimizationStats* stats = nullptr)
+    {
+        GraphOptimizationStats localStats;
+        GraphOptimizationStats& s = stats ? *stats : localStats;
+        s = GraphOptimizationStats();
+        s.nodesBefore = graph.nodeCount();
+
+        xad::JITGraph result(graph);
+        std::vector<std::size_t> runtimeConstants(options.runtimeConstants);
+        std::sort(runtimeConstants.begin(), runtimeConstants.end());
+
+        if (options.foldConstants)
+            s.constantsFolded = foldConstants(result, runtimeConstants);
+
+        std::vector<char> live;
+        markLive(result, options.eliminateDeadCode, live);
+        compact(result, live, options.eliminateCommonSubexpressions, runtimeConstants, s);
+
+        s.nodesAfter = result.nodeCount();
+        return result;
+    }
+
+  private:
+    typedef decltype(xad::JITGraph::nodes) NodeList;
+    typedef NodeList::value_type Node;
+
+    static bool isOp(const Node& node, ForgeOpCode op) { return static_cast<ForgeOpCode>(node.op) == op; }
+
+    static bool isRuntimeConstant(const std::vector<std::size_t>& runtimeConstants, const Node& node)
+    {
+        return std::binary_search(runtimeConstants.begin(), runtimeConstants.end(),
+                                  static_cast<std::size_t>(node.imm));
+    }
+
+    static uint64_t bitsOf(double value)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    // Number of operand fields an op reads, as XAD's interpreter reads them.
+    // Unused fields are left 0 by the recording and would otherwise look like
+    // references to node 0. Ops not listed return -1.
+    static int operandCount(const Node& node)
+    {
+        switch (static_cast<ForgeOpCode>(node.op))
+        {
+            case FORGE_OP_INPUT:
+            case FORGE_OP_CONSTANT:
+                return 0;
+            case FORGE_OP_NEG:
+            case FORGE_OP_ABS:
+            case FORGE_OP_SQRT:
+            case FORGE_OP_EXP:
+            case FORGE_OP_LOG:
+            case FORGE_OP_SIN:
+            case FORGE_OP_COS:
+            case FORGE_OP_TAN:
+                return 1;
+            case FORGE_OP_ADD:
+            case FORGE_OP_SUB:
+            case FORGE_OP_MUL:
+            case FORGE_OP_DIV:
+            case FORGE_OP_POW:
+            case FORGE_OP_MIN:
+            case FORGE_OP_MAX:
+                return 2;
+            case FORGE_OP_IF:
+                return 3;
+            default:
+                return -1;
+        }
+    }
+
+    // Calls f for each operand of node i. For ops of unknown arity every
+    // field smaller than i counts as an operand (the convention of the Forge
+    // translation); that may keep a dead node or miss a fold, but never drops
+    // an operand.
+    template <class F>
+    static void forEachOperand(const Node& node, std::size_t i, F f)
+    {
+        const uint32_t fields[3] = {node.a, node.b, node.c};
+        const int count = operandCount(node);
+        for (int k = 0; k < (count < 0 ? 3 : count); ++k)
+        {
+            if (fields[k] < i)
+                f(fields[k]);
+        }
+    }
+
+    // Replace every constant-only node that is still needed by a constant
+    // node holding its value. Returns the number of nodes replaced.
+    static std::size_t foldConstants(xad::JITGraph& graph, const std::vector<std::size_t>& runtimeConstants)
+    {
+        NodeList& nodes = graph.nodes;
+        const std::size_t n = nodes.size();
+
+        // Nodes depending on (non-runtime) constants only
+        std::vector<char> constOnly(n, 0);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const Node& node = nodes[i];
+            if (isOp(node, FORGE_OP_CONSTANT))
+            {
+                constOnly[i] = !isRuntimeConstant(runtimeConstants, node);
+                continue;
+            }
+            if (isOp(node, FORGE_OP_INPUT))
+                continue;
+            bool allConst = true;
+            forEachOperand(node, i, [&](uint32_t x) { allConst = allConst && constOnly[x]; });
+            constOnly[i] = allConst;
+        }
+
+        // Computed constant-only nodes whose value is used outside the constant part
+        std::vector<char> needed(n, 0);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (constOnly[i])
+                continue;
+            forEachOperand(nodes[i], i, [&](uint32_t x) { needed[x] = constOnly[x]; });
+        }
+        for (std::size_t k = 0; k < graph.output_ids.size(); ++k)
+            needed[graph.output_ids[k]] = constOnly[graph.output_ids[k]];
+
+        // Evaluate the constant part once with XAD's interpreter
+        xad::JITGraph constant(graph);
+        constant.nodes.clear();
+        constant.input_ids.clear();
+        constant.output_ids.clear();
+        std::vector<uint32_t> subIndex(n, 0);
+        std::vector<uint32_t> folded;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (!constOnly[i])
+                continue;
+            Node node = nodes[i];
+            if (node.a < i) node.a = subIndex[node.a];
+            if (node.b < i) node.b = subIndex[node.b];
+            if (node.c < i) node.c = subIndex[node.c];
+            subIndex[i] = static_cast<uint32_t>(constant.nodes.size());
+            constant.nodes.push_back(node);
+            if (needed[i] && !isOp(node, FORGE_OP_CONSTANT))
+            {
+                constant.output_ids.push_back(subIndex[i]);
+                folded.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        if (folded.empty())
+            return 0;
+
+        std::vector<double> values(folded.size());
+        xad::JITGraphInterpreter<double> interpreter;
+        interpreter.compile(constant);
+        interpreter.forward(values.data());
+
+        // Reuse existing const_pool entries with the same value
+        std::unordered_map<uint64_t, std::size_t> poolIndex;
+        for (std::size_t k = 0; k < graph.const_pool.size(); ++k)
+        {
+            if (!std::binary_search(runtimeConstants.begin(), runtimeConstants.end(), k))
+                poolIndex.insert(std::make_pair(bitsOf(graph.const_pool[k]), k));
+        }
+
+        for (std::size_t k = 0; k < folded.size(); ++k)
+        {
+            const uint64_t bits = bitsOf(values[k]);
+            std::unordered_map<uint64_t, std::size_t>::iterator it = poolIndex.find(bits);
+            std::size_t constIndex;
+            if (it != poolIndex.end())
+            {
+                constIndex = it->second;
+            }
+            else
+            {
+                constIndex = graph.const_pool.size();
+                graph.const_pool.push_back(values[k]);
+                poolIndex.insert(std::make_pair(bits, constIndex));
+            }
+
+            Node& node = nodes[folded[k]];
+            node.op = static_cast<decltype(node.op)>(FORGE_OP_CONSTANT);
+            node.a = node.b = node.c = 0;
+            node.imm = static_cast<double>(constIndex);
+            node.flags = 0;
+        }
+        return folded.size();
+    }
+
+    // Nodes reachable from the outputs; inputs are always kept
+    static void markLive(const xad::JITGraph& graph, bool eliminateDeadCode, std::vector<char>& live)
+    {
+        const std::size_t n = graph.nodeCount();
+        live.assign(n, eliminateDeadCode ? 0 : 1);
+        if (!eliminateDeadCode)
+            return;
+
+        for (std::size_t k = 0; k < graph.output_ids.size(); ++k)
+            live[graph.output_ids[k]] = 1;
+        for (std::size_t i = n; i-- > 0;)
+        {
+            if (isOp(graph.nodes[i], FORGE_OP_INPUT))
+                live[i] = 1;
+            if (live[i])
+                forEachOperand(graph.nodes[i], i, [&](uint32_t x) { live[x] = 1; });
+        }
+    }
+
+    struct NodeKey
+    {
+        uint32_t op, a, b, c;
+        uint64_t imm;
+        uint32_t flags;
+
+        bool operator==(const NodeKey& other) const
+        {
+            return op == other.op && a == other.a && b == other.b && c == other.c && imm == other.imm &&
+                   flags == other.flags;
+        }
+    };
+
+    struct NodeKeyHash
+    {
+        std::size_t operator()(const NodeKey& key) const
+        {
+            uint64_t h = 14695981039346656037ULL;
+            const uint64_t parts[6] = {key.op, key.a, key.b, key.c, key.imm, key.flags};
+            for (int i = 0; i < 6; ++i)
+                h = (h ^ parts[i]) * 1099511628211ULL;
+            return static_cast<std::size_t>(h ^ (h >> 32));
+        }
+    };
+
+    // Drop dead nodes, merge duplicates and renumber
+    static void compact(xad::JITGraph& graph, const std::vector<char>& live, bool eliminateCommonSubexpressions,
+                        const std::vector<std::size_t>& runtimeConstants, GraphOptimizationStats& s)
+    {
+        const NodeList& nodes = graph.nodes;
+        const std::size_t n = nodes.size();
+
+        NodeList result;
+        result.reserve(n);
+        std::vector<uint32_t> newIndex(n, 0);
+        std::unordered_map<NodeKey, uint32_t, NodeKeyHash> seen;
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (!live[i])
+            {
+                ++s.deadNodesRemoved;
+                continue;
+            }
+
+            Node node = nodes[i];
+            if (node.a < i) node.a = newIndex[node.a];
+            if (node.b < i) node.b = newIndex[node.b];
+            if (node.c < i) node.c = newIndex[node.c];
+
+            if (eliminateCommonSubexpressions && !isOp(node, FORGE_OP_INPUT))
+            {
+                NodeKey key;
+                key.op = static_cast<uint32_t>(node.op);
+                key.flags = static_cast<uint32_t>(node.flags);
+                if (isOp(node, FORGE_OP_CONSTANT))
+                {
+                    // Equal values are the same constant; runtime constants only by index
+                    const bool runtime = isRuntimeConstant(runtimeConstants, node);
+                    key.a = runtime ? 1 : 0;
+                    key.b = key.c = 0;
+                    key.imm = runtime ? bitsOf(node.imm)
+                                      : bitsOf(graph.const_pool[static_cast<std::size_t>(node.imm)]);
+                }
+                else
+                {
+                    key.a = node.a;
+                    key.b = node.b;
+                    key.c = node.c;
+                    key.imm = bitsOf(node.imm);
+                }
+
+                std::unordered_map<NodeKey, uint32_t, NodeKeyHash>::iterator it = seen.find(key);
+                if (it != seen.end())
+                {
+                    newIndex[i] = it->second;
+                    ++s.duplicatesMerged;
+                    continue;
+                }
+                seen.insert(std::make_pair(key, static_cast<uint32_t>(result.size())));
+            }
+
+            newIndex[i] = static_cast<uint32_t>(result.size());
+            result.push_back(node);
+        }
+
+        for (std::size_t k = 0; k < graph.input_ids.size(); ++k)
+            graph.input_ids[k] = newIndex[graph.input_ids[k]];
+        for (std::size_t k = 0; k < graph.output_ids.size(); ++k)
+            graph.output_ids[k] = newIndex[graph.output_ids[k]];
+        graph.nodes.swap(result);
+    }
+};
+
+}  // namespace forge
+}  // namespace xad
@@ -0,0 +1,316 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  KernelCache - In-process cache of compiled Forge kernels
+//
+//  This file is part of xad-forge, providing Forge JIT compilation
+//  as a backend for XAD automatic differentiation.
+//
+//  Graphs recorded from the same code with the same constants hash equally
+//  (see GraphHash.hpp), so they can share one compiled ForgeKernel instead of
+//  each being translated and compiled again. The cache keeps the most
+//  recently used kernels within a byte budget and evicts the least recently
+//  used ones beyond it.
+//
+//  Copyright (c) 2025 The xad-forge Authors
+//  https://github.com/da-roth/xad-forge
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <XAD/JITGraph.hpp>
+
+#include <xad-forge/ForgeKernel.hpp>
+#include <xad-forge/GraphHash.hpp>
+
+// Forge C API - stable ABI
+#include <forge_c_api.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace xad
+{
+namespace forge
+{
+
+/**
+ * Thread-safe LRU cache of compiled kernels, keyed by GraphHash.
+ *
+ * Evicting a kernel only drops the cache's reference; backends that still
+ * use it keep it alive. Each entry also keeps a copy of the graph it was
+ * compiled from, and a hit is only returned if the requested graph matches
+ * that copy exactly (apart from the values of runtime constants), so a
+ * GraphHash collision costs a compilation instead of returning a kernel for
+ * another graph. The byte budget is measured at insertion with
+ * ForgeKernel::estimatedBytes(), which includes the ForgeGraph each cached
+ * kernel retains, plus the graph copy. A single kernel larger than the whole
+ * budget is returned but not retained.
+ *
+ * Usage:
+ *   xad::forge::ForgeBackendAVX<double> avx;
+ *   avx.setKernelCache(&xad::forge::KernelCache::global());
+ *   avx.compile(jit.getGraph());  // reuses an identical earlier compilation
+ */
+class KernelCache
+{
+  public:
+    /// Default budget of the global cache
+    static const std::size_t DEFAULT_BYTE_BUDGET = std::size_t(256) << 20;
+
+    explicit KernelCache(std::size_t byteBudget = DEFAULT_BYTE_BUDGET)
+        : byteBudget_(byteBudget)
+        , bytesUsed_(0)
+        , hits_(0)
+        , misses_(0)
+    {
+    }
+
+    // No copy
+    KernelCache(const KernelCache&) = delete;
+    KernelCache& operator=(const KernelCache&) = delete;
+
+    /**
+     * Process-wide cache shared by all backends that opt in.
+     */
+    static KernelCache& global()
+    {
+        static KernelCache cache;
+        return cache;
+    }
+
+    /**
+     * Return the cached kernel for this graph, compiling it on a miss.
+     *
+     * Compilation runs without holding the cache lock, so different graphs
+     * compile concurrently. If two threads miss on the same graph at once,
+     * both compile and the first kernel inserted is kept.
+     *
+     * With runtimeConstants (see ForgeKernel::compile()) graphs differing only
+     * in those constants' values share one kernel; the returned kernel's
+     * parameterDefaults() may then come from another graph, so callers set
+     * the values they need with ForgeBuffer::setConstant().
+     *
+     * If compiled is not null, it is set to whether this call compiled the
+     * graph rather than returning a cached kernel.
+     */
+    std::shared_ptr<const ForgeKernel> getOrCompile(const xad::JITGraph& jitGraph,
+                                                    ForgeInstructionSet instructionSet,
+                                                    bool useGraphOptimizations = false,
+                                                    std::vector<std::size_t> runtimeConstants =
+                                                        std::vector<std::size_t>(),
+                                                    bool* compiled = nullptr)
+    {
+        if (compiled)
+            *compiled = false;
+        std::sort(runtimeConstants.begin(), runtimeConstants.end());
+        runtimeConstants.erase(std::unique(runtimeConstants.begin(), runtimeConstants.end()),
+                               runtimeConstants.end());
+        const GraphHash key =
+            GraphHash::compute(jitGraph, instructionSet, useGraphOptimizations, runtimeConstants);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::shared_ptr<const ForgeKernel> kernel =
+                lookup(key, jitGraph, instructionSet, useGraphOptimizations, runtimeConstants);
+            if (kernel)
+            {
+                ++hits_;
+                return kernel;
+            }
+            ++misses_;
+        }
+
+        std::shared_ptr<const ForgeKernel> kernel =
+            ForgeKernel::compile(jitGraph, instructionSet, useGraphOptimizations, runtimeConstants);
+        if (compiled)
+            *compiled = true;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::shared_ptr<const ForgeKernel> existing =
+            lookup(key, jitGraph, instructionSet, useGraphOptimizations, runtimeConstants);
+        if (existing)
+            return existing;
+        insert(key, kernel, jitGraph, instructionSet, useGraphOptimizations, runtimeConstants);
+        return kernel;
+    }
+
+    /**
+     * Change the byte budget, evicting kernels if it shrank.
+     */
+    void setByteBudget(std::size_t byteBudget)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        byteBudget_ = byteBudget;
+        evict();
+    }
+
+    /// Drop all cached kernels and reset the statistics
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        index_.clear();
+        bytesUsed_ = 0;
+        hits_ = 0;
+        misses_ = 0;
+    }
+
+    std::size_t byteBudget() const { std::lock_guard<std::mutex> lock(mutex_); return byteBudget_; }
+    std::size_t bytesUsed() const { std::lock_guard<std::mutex> lock(mutex_); return bytesUsed_; }
+    std::size_t size() const { std::lock_guard<std::mutex> lock(mutex_); return entries_.size(); }
+    std::size_t hits() const { std::lock_guard<std::mutex> lock(mutex_); return hits_; }
+    std::size_t misses() const { std::lock_guard<std::mutex> lock(mutex_); return misses_; }
+
+  private:
+    struct Entry
+    {
+        GraphHash key;
+        std::shared_ptr<const ForgeKernel> kernel;
+        std::size_t bytes;
+        // What the kernel was compiled from, compared on every hit
+        xad::JITGraph graph;
+        ForgeInstructionSet instructionSet;
+        bool useGraphOptimizations;
+        std::vector<std::size_t> runtimeConstants;
+    };
+    typedef std::list<Entry> EntryList;  // most recently used first
+
+    // Requires mutex_ held. Moves a hit to the front; an entry with the same
+    // key but a different graph is not a hit.
+    std::shared_ptr<const ForgeKernel> lookup(const GraphHash& key, const xad::JITGraph& jitGraph,
+                                              ForgeInstructionSet instructionSet, bool useGraphOptimizations,
+                                              const std::vector<std::size_t>& runtimeConstants)
+    {
+        std::map<GraphHash, EntryList::iterator>::iterator it = index_.find(key);
+        if (it == index_.end())
+            return std::shared_ptr<const ForgeKernel>();
+        const Entry& entry = *it->second;
+        if (entry.instructionSet != instructionSet || entry.useGraphOptimizations != useGraphOptimizations ||
+            entry.runtimeConstants != runtimeConstants || !sameGraph(entry.graph, jitGraph, runtimeConstants))
+            return std::shared_ptr<const ForgeKernel>();
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->kernel;
+    }
+
+    // Requires mutex_ held. Replaces an entry with the same key.
+    void insert(const GraphHash& key, const std::shared_ptr<const ForgeKernel>& kernel,
+                const xad::JITGraph& jitGraph, ForgeInstructionSet instructionSet, bool useGraphOptimizations,
+                const std::vector<std::size_t>& runtimeConstants)
+    {
+        const std::size_t bytes = kernel->estimatedBytes() + graphBytes(jitGraph);
+        if (bytes > byteBudget_)
+            return;
+
+        std::map<GraphHash, EntryList::iterator>::iterator it = index_.find(key);
+        if (it != index_.end())
+        {
+            bytesUsed_ -= it->second->bytes;
+            entries_.erase(it->second);
+            index_.erase(it);
+        }
+
+        entries_.push_front(Entry());
+        Entry& entry = entries_.front();
+        entry.key = key;
+        entry.kernel = kernel;
+        entry.bytes = bytes;
+        entry.graph = jitGraph;
+        entry.instructionSet = instructionSet;
+        entry.useGraphOptimizations = useGraphOptimizations;
+        entry.runtimeConstants = runtimeConstants;
+        index_[key] = entries_.begin();
+        bytesUsed_ += bytes;
+        evict();
+    }
+
+    /**
+     * Whether a and b compile to the same kernel: equal nodes, inputs,
+     * outputs and constants, except the values of the runtime constants
+     * (sorted const_pool indices). Values are compared bitwise, like
+     * GraphHash does.
+     */
+    static bool sameGraph(const xad::JITGraph& a, const xad::JITGraph& b,
+                          const std::vector<std::size_t>& runtimeConstants)
+    {
+        if (a.nodeCount() != b.nodeCount() || a.const_pool.size() != b.const_pool.size() ||
+            a.input_ids != b.input_ids || a.output_ids != b.output_ids)
+            return false;
+
+        for (std::size_t i = 0; i < a.nodeCount(); ++i)
+        {
+            const auto& x = a.nodes[i];
+            const auto& y = b.nodes[i];
+            if (x.op != y.op || x.a != y.a || x.b != y.b || x.c != y.c || x.flags != y.flags ||
+                !sameBits(x.imm, y.imm))
+                return false;
+        }
+
+        std::size_t nextParameter = 0;
+        for (std::size_t i = 0; i < a.const_pool.size(); ++i)
+        {
+            if (nextParameter < runtimeConstants.size() && runtimeConstants[nextParameter] == i)
+            {
+                ++nextParameter;
+                continue;
+            }
+            if (!sameBits(a.const_pool[i], b.const_pool[i]))
+                return false;
+        }
+        return true;
+    }
+
+    static bool sameBits(double a, double b) { return std::memcmp(&a, &b, sizeof(double)) == 0; }
+
+    /// Approximate bytes of the graph copy kept by an entry
+    static std::size_t graphBytes(const xad::JITGraph& graph)
+    {
+        return graph.nodeCount() * sizeof(graph.nodes[0]) + graph.const_pool.size() * sizeof(double) +
+               (graph.input_ids.size() + graph.output_ids.size()) * sizeof(graph.input_ids[0]);
+    }
+
+    // Requires mutex_ held
+    void evict()
+    {
+        while (bytesUsed_ > byteBudget_ && !entries_.empty())
+        {
+            const Entry& last = entries_.back();
+            bytesUsed_ -= last.bytes;
+            index_.erase(last.key);
+            entries_.pop_back();
+        }
+    }
+
+    mutable std::mutex mutex_;
+    EntryList entries_;
+    std::map<GraphHash, EntryList::iterator> index_;
+    std::size_t byteBudget_;
+    std::size_t bytesUsed_;
+    std::size_t hits_;
+    std::size_t misses_;
+};
+
+}  // namespace forge
+}  // namespace xad
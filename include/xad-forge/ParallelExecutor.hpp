@@ -0,0 +1,456 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  ParallelExecutor - Multi-threaded Monte Carlo execution on Forge kernels
+//
+//  This file is part of xad-forge, providing Forge JIT compilation
+//  as a backend for XAD automatic differentiation.
+//
+//  Distributes the paths of a Monte Carlo run across worker threads. All
+//  workers execute the same shared ForgeKernel, each on its own ForgeBuffer,
+//  so the graph is compiled only once regardless of the thread count.
+//
+//  Copyright (c) 2025 The xad-forge Authors
+//  https://github.com/da-roth/xad-forge
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <XAD/JITGraph.hpp>
+
+#include <xad-forge/ForgeKernel.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace xad
+{
+namespace forge
+{
+
+/**
+ * Runs a compiled ForgeKernel over many independent paths on a pool of
+ * worker threads.
+ *
+ * Paths are split into chunks (a multiple of the kernel's vector width).
+ * Idle workers pick up the next unprocessed chunk, so threads that finish
+ * early take over work from slower ones. Each worker keeps its own
+ * ForgeBuffer, reused across runs.
+ *
+ * The worker threads are started on the first run and wait for the next
+ * one in between, so repeated runs do not pay for thread creation; they
+ * are joined when the executor is destroyed. The calling thread works as
+ * one of the workers. Runs on one executor must not overlap.
+ *
+ * Reduced results are summed per chunk and then combined in chunk order,
+ * so they do not depend on the number of threads or on scheduling.
+ *
+ * Runtime constants are held by the executor and applied to every worker
+ * buffer. They start at the kernel's recorded values, or at the backend's
+ * current values when constructed from a backend, and can be changed with
+ * setConstant(), setConstants() or loadConstants().
+ *
+ * Usage:
+ *   xad::forge::ForgeBackendAVX<double> avx;
+ *   avx.compile(jit.getGraph());
+ *   xad::forge::ParallelExecutor exec(avx);
+ *   auto result = exec.runReduced(numPaths, [&](std::size_t path, double* inputs) {
+ *       // fill avx.numInputs() values for this path
+ *   });
+ */
+class ParallelExecutor
+{
+  public:
+    /**
+     * Fills the numInputs() input values of one path.
+     * Called concurrently from several workers with distinct path indices,
+     * so it must be thread-safe (e.g. a counter-based RNG keyed on path).
+     */
+    typedef std::function<void(std::size_t path, double* inputs)> InputGenerator;
+
+    /// Sums over all paths of a reduced run
+    struct Result
+    {
+        std::size_t numPaths;
+        std::vector<double> outputSums;    ///< numOutputs() entries
+        std::vector<double> gradientSums;  ///< numInputs() entries, empty without gradients
+    };
+
+    /**
+     * @param kernel        compiled kernel to execute
+     * @param numThreads    worker count, 0 = std::thread::hardware_concurrency()
+     * @param pathsPerChunk paths per scheduling unit, rounded up to the
+     *                      vector width, 0 = 256 batches
+     */
+    explicit ParallelExecutor(std::shared_ptr<const ForgeKernel> kernel, std::size_t numThreads = 0,
+                              std::size_t pathsPerChunk = 0)
+        : kernel_(std::move(kernel))
+        , job_(nullptr)
+        , jobWorkers_(0)
+        , pending_(0)
+        , generation_(0)
+        , stopping_(false)
+    {
+        if (!kernel_)
+            throw std::invalid_argument("ParallelExecutor requires a compiled kernel");
+        constants_ = kernel_->parameterDefaults();
+
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        buffers_.resize(numThreads);
+
+        const std::size_t width = kernel_->vectorWidth();
+        if (pathsPerChunk == 0)
+            pathsPerChunk = 256 * width;
+        chunkSize_ = (pathsPerChunk + width - 1) / width * width;
+    }
+
+    /**
+     * Execute the kernel of a compiled ForgeBackend or ForgeBackendAVX, with
+     * the backend's current runtime constants. Only takes part in overload
+     * resolution for types with kernel() and constants(), so kernel pointers
+     * such as the result of ForgeKernel::compile() use the constructor above.
+     */
+    template <class Backend, class = decltype(std::declval<const Backend&>().kernel()),
+              class = decltype(std::declval<const Backend&>().constants())>
+    explicit ParallelExecutor(const Backend& backend, std::size_t numThreads = 0, std::size_t pathsPerChunk = 0)
+        : ParallelExecutor(backend.kernel(), numThreads, pathsPerChunk)
+    {
+        setConstants(backend.constants());
+    }
+
+    ~ParallelExecutor()
+    {
+        stopWorkers();
+    }
+
+    // No copy (owns its worker threads)
+    ParallelExecutor(const ParallelExecutor&) = delete;
+    ParallelExecutor& operator=(const ParallelExecutor&) = delete;
+
+    std::size_t numThreads() const { return buffers_.size(); }
+    std::size_t pathsPerChunk() const { return chunkSize_; }
+    std::size_t numInputs() const { return kernel_->numInputs(); }
+    std::size_t numOutputs() const { return kernel_->numOutputs(); }
+
+    /**
+     * Change a runtime constant (a const_pool index) for all workers, from
+     * the next run on.
+     */
+    void setConstant(std::size_t constIndex, double value)
+    {
+        const std::size_t slot = kernel_->parameterSlot(constIndex);
+        if (slot == constants_.size())
+            throw std::invalid_argument("Constant is not a runtime constant of this kernel");
+        constants_[slot] = value;
+        applyConstants();
+    }
+
+    /// Runtime constant values, in kernel runtimeConstants() order
+    const std::vector<double>& constants() const { return constants_; }
+
+    void setConstants(const std::vector<double>& values)
+    {
+        if (values.size() != constants_.size())
+            throw std::invalid_argument("Expected one value per runtime constant");
+        constants_ = values;
+        applyConstants();
+    }
+
+    /**
+     * Set every runtime constant to its value in jitGraph's const_pool, e.g.
+     * when the kernel came from a KernelCache and was compiled from another
+     * graph of the same structure.
+     */
+    void loadConstants(const xad::JITGraph& jitGraph)
+    {
+        const std::vector<std::size_t>& indices = kernel_->runtimeConstants();
+        for (std::size_t slot = 0; slot < indices.size(); ++slot)
+            constants_[slot] = jitGraph.const_pool[indices[slot]];
+        applyConstants();
+    }
+
+    /**
+     * Evaluate numPaths paths and store per-path results.
+     *
+     * outputsSoA receives numOutputs() rows of numPaths values
+     * (outputsSoA[o * numPaths + p]). If gradientsSoA is non-null it receives
+     * numInputs() rows likewise; otherwise only the forward-only kernel runs.
+     */
+    void run(std::size_t numPaths, const InputGenerator& generator, double* outputsSoA,
+             double* gradientsSoA = nullptr)
+    {
+        const bool withGradients = gradientsSoA != nullptr;
+        execute(numPaths, generator, withGradients ? Evaluate : Forward,
+                [&](std::size_t, std::size_t first, std::size_t count, const double* outputs,
+                    const double* gradients) {
+                    for (std::size_t o = 0; o < numOutputs(); ++o)
+                        std::copy(outputs + o * count, outputs + (o + 1) * count,
+                                  outputsSoA + o * numPaths + first);
+                    if (!withGradients)
+                        return;
+                    for (std::size_t i = 0; i < numInputs(); ++i)
+                        std::copy(gradients + i * count, gradients + (i + 1) * count,
+                                  gradientsSoA + i * numPaths + first);
+                });
+    }
+
+    /**
+     * Evaluate numPaths paths and return the sums of outputs and, if
+     * withGradients is set, of input gradients over all paths.
+     *
+     * With gradients, per-path results are never materialised: each worker
+     * accumulates its chunk directly in its buffer's running sums.
+     */
+    Result runReduced(std::size_t numPaths, const InputGenerator& generator, bool withGradients = true)
+    {
+        const std::size_t nOut = numOutputs();
+        const std::size_t nIn = withGradients ? numInputs() : 0;
+        const std::size_t numChunks = (numPaths + chunkSize_ - 1) / chunkSize_;
+
+        // One row of partial sums per chunk, combined in chunk order below
+        std::vector<double> partials(numChunks * (nOut + nIn), 0.0);
+        execute(numPaths, generator, withGradients ? Accumulate : Forward,
+                [&](std::size_t chunk, std::size_t, std::size_t count, const double* outputs,
+                    const double* gradients) {
+                    double* row = partials.data() + chunk * (nOut + nIn);
+                    if (withGradients)
+                    {
+                        std::copy(outputs, outputs + nOut, row);
+                        std::copy(gradients, gradients + nIn, row + nOut);
+                        return;
+                    }
+                    for (std::size_t o = 0; o < nOut; ++o)
+                        for (std::size_t p = 0; p < count; ++p)
+                            row[o] += outputs[o * count + p];
+                });
+
+        Result result;
+        result.numPaths = numPaths;
+        result.outputSums.assign(nOut, 0.0);
+        result.gradientSums.assign(nIn, 0.0);
+        for (std::size_t chunk = 0; chunk < numChunks; ++chunk)
+        {
+            const double* row = partials.data() + chunk * (nOut + nIn);
+            for (std::size_t o = 0; o < nOut; ++o)
+                result.outputSums[o] += row[o];
+            for (std::size_t i = 0; i < nIn; ++i)
+                result.gradientSums[i] += row[nOut + i];
+        }
+        return result;
+    }
+
+  private:
+    enum Mode
+    {
+        Forward,     ///< per-path outputs from the forward-only kernel
+        Evaluate,    ///< per-path outputs and gradients
+        Accumulate   ///< per-chunk sums of outputs and gradients
+    };
+
+    /// Per-chunk results: (chunk, firstPath, count, outputs, gradients). In
+    /// Accumulate mode the arrays hold the chunk's sums; otherwise they are
+    /// SoA with row stride count.
+    typedef std::function<void(std::size_t, std::size_t, std::size_t, const double*, const double*)>
+        ChunkConsumer;
+
+    void execute(std::size_t numPaths, const InputGenerator& generator, Mode mode,
+                 const ChunkConsumer& consume)
+    {
+        if (numPaths == 0)
+            return;
+
+        const std::size_t numChunks = (numPaths + chunkSize_ - 1) / chunkSize_;
+        const std::size_t numWorkers = std::min(buffers_.size(), numChunks);
+
+        std::atomic<std::size_t> nextChunk(0);
+        std::atomic<bool> failed(false);
+        std::vector<std::exception_ptr> errors(numWorkers);
+
+        const std::function<void(std::size_t)> worker = [&](std::size_t w) {
+            try
+            {
+                ForgeBuffer& buffer = buffers_[w];
+                if (!buffer.valid())
+                {
+                    buffer = ForgeBuffer(kernel_);
+                    buffer.setConstants(constants_);
+                }
+
+                const std::size_t nIn = numInputs();
+                const std::size_t nOut = numOutputs();
+                std::vector<double> pathInputs(nIn);
+                std::vector<double> inputs(nIn * chunkSize_);
+                const std::size_t rows = mode == Accumulate ? 1 : chunkSize_;
+                std::vector<double> outputs(nOut * rows);
+                std::vector<double> gradients(mode == Forward ? 0 : nIn * rows);
+
+                while (!failed.load(std::memory_order_relaxed))
+                {
+                    const std::size_t chunk = nextChunk.fetch_add(1);
+                    if (chunk >= numChunks)
+                        break;
+
+                    const std::size_t first = chunk * chunkSize_;
+                    const std::size_t count = std::min(chunkSize_, numPaths - first);
+
+                    for (std::size_t p = 0; p < count; ++p)
+                    {
+                        generator(first + p, pathInputs.data());
+                        for (std::size_t i = 0; i < nIn; ++i)
+                            inputs[i * count + p] = pathInputs[i];
+                    }
+
+                    if (mode == Accumulate)
+                    {
+                        buffer.clearAccumulators();
+                        buffer.accumulate(count, inputs.data());
+                        buffer.getAccumulatedOutputs(outputs.data());
+                        buffer.getAccumulatedGradients(gradients.data());
+                    }
+                    else
+                    {
+                        buffer.evaluate(count, inputs.data(), outputs.data(),
+                                        mode == Evaluate ? gradients.data() : nullptr);
+                    }
+                    consume(chunk, first, count, outputs.data(), gradients.data());
+                }
+            }
+            catch (...)
+            {
+                errors[w] = std::current_exception();
+                failed = true;
+            }
+        };
+
+        // The calling thread acts as worker 0, pool thread w - 1 as worker w
+        if (numWorkers > 1 && threads_.empty())
+            startWorkers();
+        {
+            std::lock_guard<std::mutex> lock(poolMutex_);
+            job_ = &worker;
+            jobWorkers_ = numWorkers;
+            pending_ = numWorkers - 1;
+            ++generation_;
+        }
+        if (numWorkers > 1)
+            wake_.notify_all();
+        worker(0);
+        {
+            std::unique_lock<std::mutex> lock(poolMutex_);
+            done_.wait(lock, [this]() { return pending_ == 0; });
+            job_ = nullptr;
+        }
+
+        for (auto& error : errors)
+        {
+            if (error)
+                std::rethrow_exception(error);
+        }
+    }
+
+    void startWorkers()
+    {
+        try
+        {
+            threads_.reserve(buffers_.size() - 1);
+            for (std::size_t w = 1; w < buffers_.size(); ++w)
+                threads_.emplace_back(&ParallelExecutor::workerLoop, this, w);
+        }
+        catch (...)
+        {
+            stopWorkers();
+            throw;
+        }
+    }
+
+    void stopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(poolMutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& thread : threads_)
+            thread.join();
+        threads_.clear();
+        stopping_ = false;
+    }
+
+    // Pool thread running worker w of every run that needs it
+    void workerLoop(std::size_t w)
+    {
+        std::size_t seen = 0;
+        std::unique_lock<std::mutex> lock(poolMutex_);
+        for (;;)
+        {
+            wake_.wait(lock, [&]() { return stopping_ || generation_ != seen; });
+            if (stopping_)
+                return;
+            seen = generation_;
+            if (w >= jobWorkers_)
+                continue;
+
+            const std::function<void(std::size_t)>& job = *job_;
+            lock.unlock();
+            job(w);  // reports errors through the run's error list
+            lock.lock();
+            if (--pending_ == 0)
+                done_.notify_one();
+        }
+    }
+
+    void applyConstants()
+    {
+        for (auto& buffer : buffers_)
+        {
+            if (buffer.valid())
+                buffer.setConstants(constants_);
+        }
+    }
+
+    std::shared_ptr<const ForgeKernel> kernel_;
+    std::vector<double> constants_;  // runtime constants, applied to every worker buffer
+    std::vector<ForgeBuffer> buffers_;  // one per worker, created on first use
+    std::size_t chunkSize_;
+
+    // Persistent pool: numThreads() - 1 threads, started on the first run
+    std::vector<std::thread> threads_;
+    std::mutex poolMutex_;
+    std::condition_variable wake_;  // new run or stop
+    std::condition_variable done_;  // last pool worker of a run finished
+    const std::function<void(std::size_t)>* job_;  // worker of the current run
+    std::size_t jobWorkers_;  // workers taking part in the current run
+    std::size_t pending_;     // pool workers of the current run still busy
+    std::size_t generation_;  // incremented per run
+    bool stopping_;
+};
+
+}  // namespace forge
+}  // namespace xad
@@ -0,0 +1,196 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  SegmentedForgeBackend - Backend compiling repeated time steps once
+//
+//  This file is part of xad-forge, providing Forge JIT compilation
+//  as a backend for XAD automatic differentiation.
+//
+//  Graphs recorded from a time-stepping loop contain the loop body once per
+//  step. This backend compiles such graphs with SegmentedKernel (see
+//  SegmentedKernel.hpp): the repeated steps share one compiled kernel that is
+//  run once per step, so compile time and code size grow with the size of
+//  the loop body rather than with the number of steps.
+//
+//  Copyright (c) 2025 The xad-forge Authors
+//  https://github.com/da-roth/xad-forge
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <XAD/JITBackendInterface.hpp>
+#include <XAD/JITGraph.hpp>
+
+#include <xad-forge/CpuFeatures.hpp>
+#include <xad-forge/SegmentedKernel.hpp>
+
+// Forge C API - stable ABI
+#include <forge_c_api.h>
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace xad
+{
+namespace forge
+{
+
+/**
+ * Segmented Backend using Forge C API - implements xad::JITBackend interface.
+ *
+ * Results are the same as with the monolithic backends up to floating-point
+ * rounding. Each segment is a separate kernel call, so for graphs without
+ * repeated blocks this backend is slower than ForgeBackendAuto; use it where
+ * compile time of long unrolled loops dominates.
+ *
+ * Usage pattern (via JITCompiler):
+ *   xad::JITCompiler<double> jit;
+ *   // ... record graph of a time-stepping loop ...
+ *   jit.setBackend(std::make_unique<xad::forge::SegmentedForgeBackend<double>>());
+ *   jit.compile();
+ *   jit.forwardAndBackward(outputs.data(), gradients.data());
+ */
+template <class Scalar>
+class SegmentedForgeBackend : public xad::JITBackend<Scalar>
+{
+    static_assert(std::is_same<Scalar, double>::value,
+                  "SegmentedForgeBackend only supports double precision. Forge does not currently support float.");
+
+  public:
+    /**
+     * Use the widest instruction set supported by the host CPU, or a specific
+     * one. Throws std::invalid_argument if the host CPU does not support it.
+     */
+    explicit SegmentedForgeBackend(const SegmentationOptions& options = SegmentationOptions(),
+                                   ForgeInstructionSet instructionSet = bestInstructionSet(),
+                                   bool useGraphOptimizations = false)
+        : options_(options)
+        , instructionSet_(instructionSet)
+        , useOptimizations_(useGraphOptimizations)
+    {
+        if (!hostSupports(instructionSet))
+            throw std::invalid_argument("SegmentedForgeBackend: instruction set not supported by this CPU");
+    }
+
+    /**
+     * Attach to an already compiled kernel, e.g. from another thread's backend.
+     */
+    explicit SegmentedForgeBackend(std::shared_ptr<const SegmentedKernel> kernel)
+        : instructionSet_(FORGE_INSTRUCTION_SET_SSE2_SCALAR)
+        , useOptimizations_(false)
+    {
+        attach(std::move(kernel));
+    }
+
+    ~SegmentedForgeBackend() override {}
+
+    SegmentedForgeBackend(SegmentedForgeBackend&&) noexcept = default;
+    SegmentedForgeBackend& operator=(SegmentedForgeBackend&&) noexcept = default;
+
+    // No copy
+    SegmentedForgeBackend(const SegmentedForgeBackend&) = delete;
+    SegmentedForgeBackend& operator=(const SegmentedForgeBackend&) = delete;
+
+    //=========================================================================
+    // JITBackend interface implementation
+    //=========================================================================
+
+    void compile(const xad::JITGraph& jitGraph) override
+    {
+        reset();
+        attach(SegmentedKernel::compile(jitGraph, instructionSet_, options_, useOptimizations_));
+    }
+
+    void reset() override
+    {
+        buffer_ = SegmentedBuffer();
+        kernel_.reset();
+    }
+
+    std::size_t vectorWidth() const override { return ForgeKernel::vectorWidthFor(instructionSet_); }
+    std::size_t numInputs() const override { return kernel_ ? kernel_->numInputs() : 0; }
+    std::size_t numOutputs() const override { return kernel_ ? kernel_->numOutputs() : 0; }
+
+    /**
+     * Set vectorWidth() values for an input (one per parallel evaluation).
+     */
+    void setInput(std::size_t inputIndex, const Scalar* values) override
+    {
+        buffer_.setInput(inputIndex, values);
+    }
+
+    void forward(Scalar* outputs) override
+    {
+        buffer_.forward(outputs);
+    }
+
+    void forwardAndBackward(Scalar* outputs, Scalar* inputGradients) override
+    {
+        buffer_.forwardAndBackward(outputs, inputGradients);
+    }
+
+    // =========================================================================
+    // Additional Accessors
+    // =========================================================================
+
+    /**
+     * The compiled kernel, for sharing with backends on other threads.
+     * Null before compile().
+     */
+    std::shared_ptr<const SegmentedKernel> kernel() const { return kernel_; }
+
+    /**
+     * How the last compiled graph was segmented. Throws if not compiled.
+     */
+    const SegmentationStats& stats() const
+    {
+        if (!kernel_)
+            throw std::runtime_error("Backend not compiled");
+        return kernel_->stats();
+    }
+
+    /// Segmentation used by the next compile()
+    void setOptions(const SegmentationOptions& options) { options_ = options; }
+    const SegmentationOptions& options() const { return options_; }
+
+    /// Instruction set that compile() targets
+    ForgeInstructionSet instructionSet() const { return instructionSet_; }
+
+  private:
+    void attach(std::shared_ptr<const SegmentedKernel> kernel)
+    {
+        if (!kernel)
+            throw std::invalid_argument("SegmentedForgeBackend requires a compiled kernel");
+        buffer_ = SegmentedBuffer(kernel);
+        instructionSet_ = kernel->instructionSet();
+        kernel_ = std::move(kernel);
+    }
+
+    SegmentationOptions options_;
+    ForgeInstructionSet instructionSet_;
+    bool useOptimizations_;
+    std::shared_ptr<const SegmentedKernel> kernel_;
+    SegmentedBuffer buffer_;
+};
+
+}  // namespace forge
+}  // namespace xad
@@ -0,0 +1,1015 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  SegmentedKernel - Graph compiled as a chain of segments, with repeated
+//                    blocks sharing one kernel
+//
+//  This file is part of xad-forge, providing Forge JIT compilation
+//  as a backend for XAD automatic differentiation.
+//
+//  A time-stepping model records the same block of operations once per time
+//  step, so its JITGraph is that block unrolled many times. Compiled
+//  monolithically, every copy becomes straight-line code. SegmentedKernel
+//  cuts the graph into consecutive segments, detects segments that are the
+//  same computation on different values (a rerolled loop body) and compiles
+//  each distinct segment once. At execution time the segments run in order,
+//  with the values that cross segment boundaries passed between them; the
+//  backward sweep runs the segments in reverse and seeds each with the
+//  adjoints of its outputs.
+//
+//  The same machinery partitions very large graphs: with a segment size
+//  limit, each partition is compiled as its own Forge graph, so no single
+//  Forge compilation grows with the whole graph, and distinct partitions
+//  compile in parallel. The partition graphs are kept to create buffers,
+//  so the memory held after compiling still grows with the graph. Outputs
+//  are computed by the same operations as in the monolithic kernel;
+//  gradients sum adjoints at partition boundaries in a different order
+//  and can differ in the last bits.
+//
+//  Copyright (c) 2025 The xad-forge Authors
+//  https://github.com/da-roth/xad-forge
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <XAD/JITGraph.hpp>
+
+#include <xad-forge/ForgeGraph.hpp>
+#include <xad-forge/ForgeKernel.hpp>
+
+// Forge C API - stable ABI
+#include <forge_c_api.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace xad
+{
+namespace forge
+{
+
+/**
+ * How SegmentedKernel cuts a graph into segments.
+ */
+struct SegmentationOptions
+{
+    SegmentationOptions()
+        : reroll(true)
+        , minBlockNodes(32)
+        , minRepeats(4)
+        , maxSegmentNodes(0)
+        , compileThreads(1)
+    {
+    }
+
+    bool reroll;                  ///< detect repeated blocks and compile each distinct one once
+    std::size_t minBlockNodes;    ///< shortest block; shorter loop bodies are grouped several per block
+    std::size_t minRepeats;       ///< fewest consecutive repeats worth rerolling
+    std::size_t maxSegmentNodes;  ///< split longer segments (0 = no limit)
+    std::size_t compileThreads;   ///< threads compiling distinct segments (0 = one per hardware thread)
+};
+
+/**
+ * Shape of a compiled SegmentedKernel.
+ */
+struct SegmentationStats
+{
+    std::size_t nodes;             ///< nodes in the source graph
+    std::size_t segments;          ///< segments executed per evaluation
+    std::size_t sharedSegments;    ///< segments running a kernel shared with other segments
+    std::size_t kernels;           ///< distinct segment kernels compiled
+    std::size_t nodesCompiled;     ///< nodes in all compiled segment kernels together
+    std::size_t boundaryValues;    ///< values passed between segments
+    std::size_t largestSegment;    ///< nodes in the largest compiled segment
+    std::size_t compileThreads;    ///< threads used to compile the segments
+    double compileMs;              ///< wall-clock time to translate and compile all segments
+};
+
+/**
+ * Compiled segmented graph. Created through SegmentedKernel::compile() and
+ * only handed out as std::shared_ptr<const SegmentedKernel>; like
+ * ForgeKernel it is read-only after construction and can be shared by
+ * SegmentedBuffer objects on several threads.
+ *
+ * Gradients follow the same convention as ForgeKernel: every output is
+ * seeded with adjoint 1.
+ */
+class SegmentedKernel
+{
+  public:
+    static std::shared_ptr<const SegmentedKernel> compile(const xad::JITGraph& jitGraph,
+                                                          ForgeInstructionSet instructionSet,
+                                                          const SegmentationOptions& options = SegmentationOptions(),
+                                                          bool useGraphOptimizations = false)
+    {
+        return std::shared_ptr<const SegmentedKernel>(
+            new SegmentedKernel(jitGraph, instructionSet, options, useGraphOptimizations));
+    }
+
+    ~SegmentedKernel()
+    {
+        cleanup();
+    }
+
+    // No copy (shared through std::shared_ptr)
+    SegmentedKernel(const SegmentedKernel&) = delete;
+    SegmentedKernel& operator=(const SegmentedKernel&) = delete;
+
+    ForgeInstructionSet instructionSet() const { return instructionSet_; }
+    std::size_t vectorWidth() const { return ForgeKernel::vectorWidthFor(instructionSet_); }
+    std::size_t numInputs() const { return inputSlots_.size(); }
+    std::size_t numOutputs() const { return outputSlots_.size(); }
+    const SegmentationStats& stats() const { return stats_; }
+
+    /**
+     * Node ranges [begin, end) the graph would be cut into. Consecutive,
+     * covering all nodes. Repeated blocks appear as ranges of equal length.
+     */
+    static std::vector<std::pair<uint32_t, uint32_t>> plan(const xad::JITGraph& jitGraph,
+                                                           const SegmentationOptions& options)
+    {
+        typedef std::pair<uint32_t, uint32_t> Range;
+        const std::size_t n = jitGraph.nodeCount();
+        std::vector<Range> blocks;
+
+        if (options.reroll && options.minBlockNodes > 0 && options.minRepeats > 1 &&
+            n >= options.minBlockNodes * options.minRepeats)
+        {
+            // Node signatures; an unrolled loop makes this sequence periodic
+            std::vector<uint32_t> sig(n);
+            for (std::size_t i = 0; i < n; ++i)
+                sig[i] = (static_cast<uint32_t>(jitGraph.nodes[i].op) << 8) ^
+                         static_cast<uint32_t>(jitGraph.nodes[i].flags);
+
+            // Candidate periods: distances between repeated windows of signatures
+            const std::size_t window = 8;
+            std::unordered_map<uint64_t, std::size_t> lastSeen;
+            std::unordered_map<std::size_t, std::size_t> periodCount;
+            for (std::size_t i = window - 1; i < n; ++i)
+            {
+                uint64_t h = 14695981039346656037ULL;
+                for (std::size_t k = i + 1 - window; k <= i; ++k)
+                    h = (h ^ sig[k]) * 1099511628211ULL;
+                std::unordered_map<uint64_t, std::size_t>::iterator it = lastSeen.find(h);
+                if (it != lastSeen.end())
+                {
+                    ++periodCount[i - it->second];
+                    it->second = i;
+                }
+                else
+                {
+                    lastSeen.insert(std::make_pair(h, i));
+                }
+            }
+
+            std::vector<std::pair<std::size_t, std::size_t>> candidates;  // (count, period)
+            for (std::unordered_map<std::size_t, std::size_t>::const_iterator it = periodCount.begin();
+                 it != periodCount.end(); ++it)
+                candidates.push_back(std::make_pair(it->second, it->first));
+            std::sort(candidates.rbegin(), candidates.rend());
+            if (candidates.size() > maxPeriodCandidates())
+                candidates.resize(maxPeriodCandidates());
+
+            // Cut runs of each candidate period into blocks of whole periods
+            // (at least minBlockNodes long), most frequent period first
+            std::vector<char> covered(n, 0);
+            for (std::size_t c = 0; c < candidates.size(); ++c)
+            {
+                const std::size_t period = candidates[c].second;
+                const std::size_t blockNodes =
+                    period * ((options.minBlockNodes + period - 1) / period);
+                std::size_t i = 0;
+                while (i + period < n)
+                {
+                    if (covered[i] || sig[i] != sig[i + period])
+                    {
+                        ++i;
+                        continue;
+                    }
+                    std::size_t j = i;
+                    while (j + period < n && !covered[j] && !covered[j + period] && sig[j] == sig[j + period])
+                        ++j;
+
+                    const std::size_t repeats = (j - i + period) / blockNodes;
+                    if (repeats < options.minRepeats)
+                    {
+                        i = j + 1;
+                        continue;
+                    }
+                    for (std::size_t k = 0; k < repeats; ++k)
+                    {
+                        const std::size_t begin = i + k * blockNodes;
+                        blocks.push_back(
+                            Range(static_cast<uint32_t>(begin), static_cast<uint32_t>(begin + blockNodes)));
+                        std::fill(covered.begin() + begin, covered.begin() + begin + blockNodes, 1);
+                    }
+                    i += repeats * blockNodes;
+                }
+            }
+            std::sort(blocks.begin(), blocks.end());
+        }
+
+        // Fill the gaps between repeated blocks with plain segments
+        std::vector<Range> ranges;
+        uint32_t next = 0;
+        for (std::size_t k = 0; k < blocks.size(); ++k)
+        {
+            if (blocks[k].first > next)
+                ranges.push_back(Range(next, blocks[k].first));
+            ranges.push_back(blocks[k]);
+            next = blocks[k].second;
+        }
+        if (next < n || ranges.empty())
+            ranges.push_back(Range(next, static_cast<uint32_t>(n)));
+        if (options.maxSegmentNodes == 0)
+            return ranges;
+
+        // Partition long segments. Node order is topological, so each part
+        // only reads values of earlier parts; equal blocks are cut equally
+        // and stay shareable.
+        std::vector<Range> parts;
+        for (std::size_t k = 0; k < ranges.size(); ++k)
+        {
+            for (uint32_t begin = ranges[k].first; begin < ranges[k].second;)
+            {
+                const uint32_t end = static_cast<uint32_t>(
+                    std::min<std::size_t>(ranges[k].second, begin + options.maxSegmentNodes));
+                parts.push_back(Range(begin, end));
+                begin = end;
+            }
+        }
+        if (parts.empty())
+            parts.push_back(Range(0, 0));
+        return parts;
+    }
+
+  private:
+    friend class SegmentedBuffer;
+
+    static uint32_t noSlot() { return 0xFFFFFFFFu; }
+    static std::size_t maxPeriodCandidates() { return 8; }
+
+    // Nodes that are not part of any segment's code: inputs are boundary
+    // values, constants are re-created (or passed in) by every segment
+    static bool isSource(const xad::JITGraph& graph, uint32_t node)
+    {
+        const ForgeOpCode op = static_cast<ForgeOpCode>(graph.nodes[node].op);
+        return op == FORGE_OP_INPUT || op == FORGE_OP_CONSTANT;
+    }
+
+    // One distinct segment computation, compiled once
+    struct Shape
+    {
+        uint32_t templateBegin;  // range of the instance the code is generated from
+        uint32_t templateEnd;
+        std::size_t templateSegment;  // index of that instance in segments_
+        std::size_t instances;
+        bool constantsAsInputs;              // constants differ between instances
+        std::vector<uint32_t> liveOutOffsets;  // sorted offsets from the range begin
+        std::size_t numLiveIns;
+        std::size_t numConstants;
+
+        ForgeGraphHandle forwardGraph;
+        ForgeKernelHandle forwardKernel;
+        std::vector<uint32_t> forwardLiveInIds;
+        std::vector<uint32_t> forwardConstantIds;
+        std::vector<uint32_t> forwardLiveOutIds;
+
+        // Gradient of sum_j seed_j * liveOut_j with respect to the live-ins
+        ForgeGraphHandle gradientGraph;
+        ForgeKernelHandle gradientKernel;
+        std::vector<uint32_t> gradientLiveInIds;
+        std::vector<uint32_t> gradientConstantIds;
+        std::vector<uint32_t> gradientSeedIds;
+    };
+
+    // One execution of a shape on specific boundary values
+    struct Segment
+    {
+        uint32_t begin;
+        uint32_t end;
+        std::size_t shape;
+        std::vector<uint32_t> liveIns;         // source graph nodes, in shape order
+        std::vector<uint32_t> constants;       // const_pool indices, in shape order
+        std::vector<uint32_t> liveInSlots;     // value-store slots
+        std::vector<uint32_t> liveOutSlots;    // value-store slots, in Shape::liveOutOffsets order
+    };
+
+    // Canonical description of a segment: equal tokens mean the same
+    // computation up to which boundary values and constants it reads
+    static void analyze(const xad::JITGraph& graph, uint32_t begin, uint32_t end, std::vector<uint64_t>* tokens,
+                        std::vector<uint32_t>& liveIns, std::vector<uint32_t>& constants)
+    {
+        std::unordered_map<uint32_t, uint32_t> liveInSlot, constantSlot;
+        liveIns.clear();
+        constants.clear();
+        if (tokens)
+            tokens->clear();
+
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const auto& node = graph.nodes[i];
+            if (isSource(graph, i))
+            {
+                if (tokens)
+                    tokens->push_back(0xFFFFFFFFFFFFFFFFULL);
+                continue;
+            }
+            if (tokens)
+            {
+                uint64_t immBits;
+                const double imm = node.imm;
+                std::memcpy(&immBits, &imm, sizeof(immBits));
+                tokens->push_back((static_cast<uint64_t>(node.op) << 8) | static_cast<uint64_t>(node.flags));
+                tokens->push_back(immBits);
+            }
+
+            const uint32_t operands[3] = {node.a, node.b, node.c};
+            for (int k = 0; k < 3; ++k)
+            {
+                const uint32_t x = operands[k];
+                uint64_t token;
+                if (x >= i)
+                {
+                    token = static_cast<uint64_t>(x);  // not a node reference
+                }
+                else if (static_cast<ForgeOpCode>(graph.nodes[x].op) == FORGE_OP_CONSTANT)
+                {
+                    const uint32_t constIndex = static_cast<uint32_t>(graph.nodes[x].imm);
+                    std::unordered_map<uint32_t, uint32_t>::iterator it = constantSlot.find(constIndex);
+                    if (it == constantSlot.end())
+                    {
+                        it = constantSlot.insert(std::make_pair(constIndex, static_cast<uint32_t>(constants.size())))
+                                 .first;
+                        constants.push_back(constIndex);
+                    }
+                    token = (1ULL << 32) | it->second;
+                }
+                else if (x >= begin && !isSource(graph, x))
+                {
+                    token = (2ULL << 32) | (x - begin);
+                }
+                else
+                {
+                    std::unordered_map<uint32_t, uint32_t>::iterator it = liveInSlot.find(x);
+                    if (it == liveInSlot.end())
+                    {
+                        it = liveInSlot.insert(std::make_pair(x, static_cast<uint32_t>(liveIns.size()))).first;
+                        liveIns.push_back(x);
+                    }
+                    token = (3ULL << 32) | it->second;
+                }
+                if (tokens)
+                    tokens->push_back(token);
+            }
+        }
+    }
+
+    SegmentedKernel(const xad::JITGraph& jitGraph, ForgeInstructionSet instructionSet,
+                    const SegmentationOptions& options, bool useGraphOptimizations)
+        : instructionSet_(instructionSet)
+    {
+        std::memset(&stats_, 0, sizeof(stats_));
+        try
+        {
+            build(jitGraph, options, useGraphOptimizations);
+        }
+        catch (...)
+        {
+            cleanup();
+            throw;
+        }
+    }
+
+    void build(const xad::JITGraph& jitGraph, const SegmentationOptions& options, bool useGraphOptimizations)
+    {
+        const std::size_t n = jitGraph.nodeCount();
+        const std::vector<std::pair<uint32_t, uint32_t>> ranges = plan(jitGraph, options);
+
+        // Segments and their distinct shapes
+        std::map<std::vector<uint64_t>, std::size_t> shapeIndex;
+        std::vector<uint64_t> tokens;
+        for (std::size_t r = 0; r < ranges.size(); ++r)
+        {
+            Segment segment;
+            segment.begin = ranges[r].first;
+            segment.end = ranges[r].second;
+            analyze(jitGraph, segment.begin, segment.end, &tokens, segment.liveIns, segment.constants);
+
+            std::map<std::vector<uint64_t>, std::size_t>::iterator it = shapeIndex.find(tokens);
+            if (it == shapeIndex.end())
+            {
+                Shape shape;
+                shape.templateBegin = segment.begin;
+                shape.templateEnd = segment.end;
+                shape.templateSegment = segments_.size();
+                shape.instances = 0;
+                shape.constantsAsInputs = false;
+                shape.numLiveIns = segment.liveIns.size();
+                shape.numConstants = segment.constants.size();
+                shape.forwardGraph = nullptr;
+                shape.forwardKernel = nullptr;
+                shape.gradientGraph = nullptr;
+                shape.gradientKernel = nullptr;
+                it = shapeIndex.insert(std::make_pair(tokens, shapes_.size())).first;
+                shapes_.push_back(shape);
+            }
+            segment.shape = it->second;
+            ++shapes_[segment.shape].instances;
+            segments_.push_back(segment);
+        }
+
+        // Shared kernels read their constants at runtime unless all instances agree
+        for (std::size_t s = 0; s < segments_.size(); ++s)
+        {
+            Shape& shape = shapes_[segments_[s].shape];
+            const Segment& first = segments_[shape.templateSegment];
+            for (std::size_t k = 0; k < shape.numConstants && !shape.constantsAsInputs; ++k)
+            {
+                if (jitGraph.const_pool[segments_[s].constants[k]] != jitGraph.const_pool[first.constants[k]])
+                    shape.constantsAsInputs = true;
+            }
+        }
+
+        // Values crossing segment boundaries: a node is a live-out of its
+        // segment if a later segment or the graph outputs read it
+        std::vector<char> liveOut(n, 0);
+        for (std::size_t s = 0; s < segments_.size(); ++s)
+        {
+            const Segment& segment = segments_[s];
+            for (std::size_t k = 0; k < segment.liveIns.size(); ++k)
+            {
+                if (!isSource(jitGraph, segment.liveIns[k]))
+                    liveOut[segment.liveIns[k]] = 1;
+            }
+        }
+        for (std::size_t k = 0; k < jitGraph.output_ids.size(); ++k)
+        {
+            if (!isSource(jitGraph, jitGraph.output_ids[k]))
+                liveOut[jitGraph.output_ids[k]] = 1;
+        }
+        for (std::size_t s = 0; s < segments_.size(); ++s)
+        {
+            const Segment& segment = segments_[s];
+            Shape& shape = shapes_[segment.shape];
+            for (uint32_t i = segment.begin; i < segment.end; ++i)
+            {
+                if (liveOut[i])
+                    shape.liveOutOffsets.push_back(i - segment.begin);
+            }
+        }
+        for (std::size_t k = 0; k < shapes_.size(); ++k)
+        {
+            std::vector<uint32_t>& offsets = shapes_[k].liveOutOffsets;
+            std::sort(offsets.begin(), offsets.end());
+            offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+        }
+
+        // Value-store slots for inputs, boundary values and outputs
+        slotOf_.assign(n, noSlot());
+        for (std::size_t k = 0; k < jitGraph.input_ids.size(); ++k)
+            inputSlots_.push_back(slotFor(jitGraph.input_ids[k]));
+        for (std::size_t s = 0; s < segments_.size(); ++s)
+        {
+            Segment& segment = segments_[s];
+            const Shape& shape = shapes_[segment.shape];
+            for (std::size_t k = 0; k < segment.liveIns.size(); ++k)
+                segment.liveInSlots.push_back(slotFor(segment.liveIns[k]));
+            for (std::size_t k = 0; k < shape.liveOutOffsets.size(); ++k)
+                segment.liveOutSlots.push_back(slotFor(segment.begin + shape.liveOutOffsets[k]));
+        }
+        for (std::size_t k = 0; k < jitGraph.output_ids.size(); ++k)
+        {
+            const uint32_t node = jitGraph.output_ids[k];
+            outputSlots_.push_back(slotFor(node));
+            if (static_cast<ForgeOpCode>(jitGraph.nodes[node].op) == FORGE_OP_CONSTANT)
+            {
+                constantOutputs_.push_back(std::make_pair(outputSlots_.back(),
+                                                          jitGraph.const_pool[static_cast<std::size_t>(
+                                                              jitGraph.nodes[node].imm)]));
+            }
+        }
+        for (std::size_t s = 0; s < segments_.size(); ++s)
+        {
+            const Segment& segment = segments_[s];
+            for (std::size_t k = 0; k < segment.constants.size(); ++k)
+                segmentConstants_.push_back(jitGraph.const_pool[segment.constants[k]]);
+        }
+
+        // Compile each shape from its template instance
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::size_t numThreads = options.compileThreads;
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        numThreads = std::min(numThreads, std::max<std::size_t>(shapes_.size(), 1));
+        compileShapes(jitGraph, numThreads, useGraphOptimizations);
+        stats_.compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stats_.compileThreads = numThreads;
+
+        stats_.nodes = n;
+        stats_.segments = segments_.size();
+        stats_.kernels = shapes_.size();
+        stats_.boundaryValues = numSlots_;
+        for (std::size_t s = 0; s < segments_.size(); ++s)
+        {
+            if (shapes_[segments_[s].shape].instances > 1)
+                ++stats_.sharedSegments;
+        }
+        for (std::size_t k = 0; k < shapes_.size(); ++k)
+        {
+            std::size_t nodes = 0;
+            for (uint32_t i = shapes_[k].templateBegin; i < shapes_[k].templateEnd; ++i)
+                nodes += isSource(jitGraph, i) ? 0 : 1;
+            stats_.nodesCompiled += nodes;
+            stats_.largestSegment = std::max(stats_.largestSegment, nodes);
+        }
+    }
+
+    // Distinct shapes are independent Forge graphs, so they compile
+    // concurrently; each thread uses its own config
+    void compileShapes(const xad::JITGraph& jitGraph, std::size_t numThreads, bool useGraphOptimizations)
+    {
+        configs_.assign(numThreads, nullptr);
+        for (std::size_t t = 0; t < numThreads; ++t)
+        {
+            configs_[t] = useGraphOptimizations ? forge_config_create_fast() : forge_config_create_default();
+            if (!configs_[t])
+                throw std::runtime_error("Forge config creation failed");
+            forge_config_set_instruction_set(configs_[t], instructionSet_);
+        }
+
+        std::atomic<std::size_t> next(0);
+        std::vector<std::exception_ptr> errors(numThreads);
+        auto worker = [&](std::size_t t) {
+            try
+            {
+                for (std::size_t k = next++; k < shapes_.size(); k = next++)
+                    compileShape(jitGraph, shapes_[k], segments_[shapes_[k].templateSegment], configs_[t]);
+            }
+            catch (...)
+            {
+                errors[t] = std::current_exception();
+                next = shapes_.size();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(numThreads - 1);
+        for (std::size_t t = 1; t < numThreads; ++t)
+            threads.push_back(std::thread(worker, t));
+        worker(0);
+        for (std::size_t t = 0; t < threads.size(); ++t)
+            threads[t].join();
+
+        for (std::size_t t = 0; t < errors.size(); ++t)
+        {
+            if (errors[t])
+                std::rethrow_exception(errors[t]);
+        }
+    }
+
+    uint32_t slotFor(uint32_t node)
+    {
+        if (slotOf_[node] == noSlot())
+            slotOf_[node] = static_cast<uint32_t>(numSlots_++);
+        return slotOf_[node];
+    }
+
+    // The forward variant outputs the live-outs; the gradient variant
+    // outputs sum_j seed_j * liveOut_j with the live-ins as diff inputs, so
+    // its adjoint sweep is seeded with the live-out adjoints
+    void compileShape(const xad::JITGraph& jitGraph, Shape& shape, const Segment& instance,
+                      ForgeConfigHandle config) const
+    {
+        if (shape.liveOutOffsets.empty())
+            return;  // nothing downstream reads this segment
+
+        const xad::JITGraph graph = segmentGraph(jitGraph, shape, instance);
+        std::vector<std::size_t> runtimeConstants;
+        if (shape.constantsAsInputs)
+        {
+            for (std::size_t k = 0; k < shape.numConstants; ++k)
+                runtimeConstants.push_back(k);
+        }
+
+        ForgeGraph::Target forward;
+        forward.graph = shape.forwardGraph = createGraph();
+        forward.withGradients = false;
+        forward.inputIds = &shape.forwardLiveInIds;
+        forward.outputIds = &shape.forwardLiveOutIds;
+        forward.parameterIds = &shape.forwardConstantIds;
+        ForgeGraph::translateGraph(graph, runtimeConstants, forward);
+        shape.forwardKernel = compileGraph(shape.forwardGraph, config);
+
+        if (shape.numLiveIns == 0)
+            return;  // no boundary value to differentiate with respect to
+
+        std::vector<uint32_t> liveOutIds;
+        ForgeGraph::Target gradient;
+        gradient.graph = shape.gradientGraph = createGraph();
+        gradient.withGradients = true;
+        gradient.inputIds = &shape.gradientLiveInIds;
+        gradient.outputIds = &liveOutIds;
+        gradient.parameterIds = &shape.gradientConstantIds;
+        gradient.seedIds = &shape.gradientSeedIds;
+        ForgeGraph::translateGraph(graph, runtimeConstants, gradient);
+        shape.gradientKernel = compileGraph(shape.gradientGraph, config);
+    }
+
+    // One segment instance as a standalone JITGraph: its live-ins become the
+    // inputs, the constants it reads const_pool entries (in Segment::constants
+    // order) and its live-outs the outputs
+    static xad::JITGraph segmentGraph(const xad::JITGraph& jitGraph, const Shape& shape, const Segment& instance)
+    {
+        typedef decltype(xad::JITGraph::nodes)::value_type Node;
+        xad::JITGraph graph;
+        std::unordered_map<uint32_t, uint32_t> liveInIndex, constantIndex;  // into graph.nodes
+        for (std::size_t k = 0; k < instance.liveIns.size(); ++k)
+        {
+            Node node = Node();
+            node.op = static_cast<decltype(node.op)>(FORGE_OP_INPUT);
+            liveInIndex[instance.liveIns[k]] = static_cast<uint32_t>(graph.nodes.size());
+            graph.input_ids.push_back(static_cast<uint32_t>(graph.nodes.size()));
+            graph.nodes.push_back(node);
+        }
+        for (std::size_t k = 0; k < instance.constants.size(); ++k)
+        {
+            Node node = Node();
+            node.op = static_cast<decltype(node.op)>(FORGE_OP_CONSTANT);
+            node.imm = static_cast<double>(k);
+            constantIndex[instance.constants[k]] = static_cast<uint32_t>(graph.nodes.size());
+            graph.const_pool.push_back(jitGraph.const_pool[instance.constants[k]]);
+            graph.nodes.push_back(node);
+        }
+
+        std::vector<uint32_t> localIndex(instance.end - instance.begin, 0);
+        for (uint32_t i = instance.begin; i < instance.end; ++i)
+        {
+            if (isSource(jitGraph, i))
+                continue;
+            Node node = jitGraph.nodes[i];
+            auto remap = [&](uint32_t x) -> uint32_t {
+                if (static_cast<ForgeOpCode>(jitGraph.nodes[x].op) == FORGE_OP_CONSTANT)
+                    return constantIndex[static_cast<uint32_t>(jitGraph.nodes[x].imm)];
+                if (x >= instance.begin && !isSource(jitGraph, x))
+                    return localIndex[x - instance.begin];
+                return liveInIndex[x];
+            };
+            if (node.a < i) node.a = remap(node.a);
+            if (node.b < i) node.b = remap(node.b);
+            if (node.c < i) node.c = remap(node.c);
+            localIndex[i - instance.begin] = static_cast<uint32_t>(graph.nodes.size());
+            graph.nodes.push_back(node);
+        }
+        for (std::size_t k = 0; k < shape.liveOutOffsets.size(); ++k)
+            graph.output_ids.push_back(localIndex[shape.liveOutOffsets[k]]);
+        return graph;
+    }
+
+    static ForgeGraphHandle createGraph()
+    {
+        ForgeGraphHandle graph = forge_graph_create();
+        if (!graph)
+            throw std::runtime_error(std::string("Forge graph creation failed: ") + forge_get_last_error());
+        return graph;
+    }
+
+    static ForgeKernelHandle compileGraph(ForgeGraphHandle graph, ForgeConfigHandle config)
+    {
+        ForgeKernelHandle kernel = forge_compile(graph, config);
+        if (!kernel)
+            throw std::runtime_error(std::string("Forge compilation failed: ") + forge_get_last_error());
+        return kernel;
+    }
+
+    void cleanup()
+    {
+        for (std::size_t k = 0; k < shapes_.size(); ++k)
+        {
+            Shape& shape = shapes_[k];
+            if (shape.gradientKernel) { forge_kernel_destroy(shape.gradientKernel); shape.gradientKernel = nullptr; }
+            if (shape.gradientGraph) { forge_graph_destroy(shape.gradientGraph); shape.gradientGraph = nullptr; }
+            if (shape.forwardKernel) { forge_kernel_destroy(shape.forwardKernel); shape.forwardKernel = nullptr; }
+            if (shape.forwardGraph) { forge_graph_destroy(shape.forwardGraph); shape.forwardGraph = nullptr; }
+        }
+        for (std::size_t t = 0; t < configs_.size(); ++t)
+        {
+            if (configs_[t])
+                forge_config_destroy(configs_[t]);
+        }
+        configs_.clear();
+    }
+
+    ForgeInstructionSet instructionSet_;
+    std::vector<ForgeConfigHandle> configs_;  // one per compile thread
+    std::vector<Shape> shapes_;
+    std::vector<Segment> segments_;
+    std::vector<double> segmentConstants_;  // const_pool values of all segments, in segment order
+
+    // Value store layout (one slot of vectorWidth() lanes per boundary value)
+    std::vector<uint32_t> slotOf_;
+    std::size_t numSlots_ = 0;
+    std::vector<uint32_t> inputSlots_;
+    std::vector<uint32_t> outputSlots_;
+    std::vector<std::pair<uint32_t, double>> constantOutputs_;  // outputs that are constants, pre-filled
+
+    SegmentationStats stats_;
+};
+
+/**
+ * Execution state for one thread running a shared SegmentedKernel: the
+ * boundary values and adjoints, and one pair of Forge buffers per distinct
+ * segment kernel. Value arrays use the same layout as ForgeBuffer.
+ */
+class SegmentedBuffer
+{
+  public:
+    SegmentedBuffer() {}
+
+    explicit SegmentedBuffer(std::shared_ptr<const SegmentedKernel> kernel)
+        : kernel_(std::move(kernel))
+    {
+        if (!kernel_)
+            throw std::invalid_argument("SegmentedBuffer requires a compiled kernel");
+        const std::size_t width = kernel_->vectorWidth();
+        values_.assign(kernel_->numSlots_ * width, 0.0);
+        adjoints_.assign(kernel_->numSlots_ * width, 0.0);
+        for (std::size_t k = 0; k < kernel_->constantOutputs_.size(); ++k)
+            std::fill(values_.begin() + kernel_->constantOutputs_[k].first * width,
+                      values_.begin() + (kernel_->constantOutputs_[k].first + 1) * width,
+                      kernel_->constantOutputs_[k].second);
+
+        const std::size_t numShapes = kernel_->shapes_.size();
+        forwardBuffers_.assign(numShapes, nullptr);
+        gradientBuffers_.assign(numShapes, nullptr);
+        try
+        {
+            for (std::size_t k = 0; k < numShapes; ++k)
+            {
+                const SegmentedKernel::Shape& shape = kernel_->shapes_[k];
+                if (shape.forwardKernel)
+                    forwardBuffers_[k] = createBuffer(shape.forwardGraph, shape.forwardKernel);
+                if (shape.gradientKernel)
+                    gradientBuffers_[k] = createBuffer(shape.gradientGraph, shape.gradientKernel);
+            }
+        }
+        catch (...)
+        {
+            cleanup();
+            throw;
+        }
+    }
+
+    ~SegmentedBuffer()
+    {
+        cleanup();
+    }
+
+    SegmentedBuffer(SegmentedBuffer&& other) noexcept
+        : kernel_(std::move(other.kernel_))
+        , forwardBuffers_(std::move(other.forwardBuffers_))
+        , gradientBuffers_(std::move(other.gradientBuffers_))
+        , values_(std::move(other.values_))
+        , adjoints_(std::move(other.adjoints_))
+        , lanes_(std::move(other.lanes_))
+    {
+        other.forwardBuffers_.clear();
+        other.gradientBuffers_.clear();
+    }
+
+    SegmentedBuffer& operator=(SegmentedBuffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            cleanup();
+            kernel_ = std::move(other.kernel_);
+            forwardBuffers_ = std::move(other.forwardBuffers_);
+            gradientBuffers_ = std::move(other.gradientBuffers_);
+            values_ = std::move(other.values_);
+            adjoints_ = std::move(other.adjoints_);
+            lanes_ = std::move(other.lanes_);
+            other.forwardBuffers_.clear();
+            other.gradientBuffers_.clear();
+        }
+        return *this;
+    }
+
+    // No copy
+    SegmentedBuffer(const SegmentedBuffer&) = delete;
+    SegmentedBuffer& operator=(const SegmentedBuffer&) = delete;
+
+    bool valid() const { return static_cast<bool>(kernel_); }
+    const std::shared_ptr<const SegmentedKernel>& kernel() const { return kernel_; }
+
+    /**
+     * Set vectorWidth() values for an input.
+     */
+    void setInput(std::size_t inputIndex, const double* values)
+    {
+        if (!kernel_)
+            throw std::runtime_error("Backend not compiled");
+        if (inputIndex >= kernel_->numInputs())
+            throw std::runtime_error("Input index out of range");
+        const std::size_t width = kernel_->vectorWidth();
+        std::copy(values, values + width, values_.begin() + kernel_->inputSlots_[inputIndex] * width);
+    }
+
+    /**
+     * Run all segments in order.
+     */
+    void forward(double* outputs)
+    {
+        if (!kernel_)
+            throw std::runtime_error("Backend not compiled");
+        runForward();
+        const std::size_t width = kernel_->vectorWidth();
+        for (std::size_t o = 0; o < kernel_->outputSlots_.size(); ++o)
+        {
+            const double* src = &values_[kernel_->outputSlots_[o] * width];
+            std::copy(src, src + width, outputs + o * width);
+        }
+    }
+
+    /**
+     * Run all segments forward, then backward in reverse order, each seeded
+     * with the adjoints of its live-outs.
+     */
+    void forwardAndBackward(double* outputs, double* inputGradients)
+    {
+        forward(outputs);
+
+        const SegmentedKernel& k = *kernel_;
+        const std::size_t width = k.vectorWidth();
+        std::fill(adjoints_.begin(), adjoints_.end(), 0.0);
+        for (std::size_t o = 0; o < k.outputSlots_.size(); ++o)
+        {
+            double* adj = &adjoints_[k.outputSlots_[o] * width];
+            for (std::size_t lane = 0; lane < width; ++lane)
+                adj[lane] += 1.0;
+        }
+
+        std::size_t constantOffset = k.segmentConstants_.size();
+        for (std::size_t s = k.segments_.size(); s-- > 0;)
+        {
+            const SegmentedKernel::Segment& segment = k.segments_[s];
+            const SegmentedKernel::Shape& shape = k.shapes_[segment.shape];
+            constantOffset -= segment.constants.size();
+            if (!shape.gradientKernel || !hasNonZeroAdjoint(segment, width))
+                continue;
+
+            ForgeBufferHandle buffer = gradientBuffers_[segment.shape];
+            setLiveIns(buffer, shape.gradientLiveInIds, segment, width);
+            if (shape.constantsAsInputs)
+                setConstants(buffer, shape.gradientConstantIds, constantOffset, width);
+            for (std::size_t j = 0; j < segment.liveOutSlots.size(); ++j)
+                forge_buffer_set_lanes(buffer, shape.gradientSeedIds[j], &adjoints_[segment.liveOutSlots[j] * width]);
+
+            forge_buffer_clear_gradients(buffer);
+            execute(shape.gradientKernel, buffer);
+
+            lanes_.resize(shape.gradientLiveInIds.size() * width);
+            forge_buffer_get_gradient_lanes(buffer, shape.gradientLiveInIds.data(), shape.gradientLiveInIds.size(),
+                                            lanes_.data());
+            for (std::size_t j = 0; j < segment.liveInSlots.size(); ++j)
+            {
+                double* adj = &adjoints_[segment.liveInSlots[j] * width];
+                for (std::size_t lane = 0; lane < width; ++lane)
+                    adj[lane] += lanes_[j * width + lane];
+            }
+        }
+
+        for (std::size_t i = 0; i < k.inputSlots_.size(); ++i)
+        {
+            const double* adj = &adjoints_[k.inputSlots_[i] * width];
+            std::copy(adj, adj + width, inputGradients + i * width);
+        }
+    }
+
+  private:
+    static ForgeBufferHandle createBuffer(ForgeGraphHandle graph, ForgeKernelHandle kernel)
+    {
+        ForgeBufferHandle buffer = forge_buffer_create(graph, kernel);
+        if (!buffer)
+            throw std::runtime_error(std::string("Forge buffer creation failed: ") + forge_get_last_error());
+        return buffer;
+    }
+
+    static void execute(ForgeKernelHandle kernel, ForgeBufferHandle buffer)
+    {
+        ForgeError err = forge_execute(kernel, buffer);
+        if (err != FORGE_SUCCESS)
+            throw std::runtime_error(std::string("Forge execution failed: ") + forge_get_last_error());
+    }
+
+    void runForward()
+    {
+        const SegmentedKernel& k = *kernel_;
+        const std::size_t width = k.vectorWidth();
+        std::size_t constantOffset = 0;
+        for (std::size_t s = 0; s < k.segments_.size(); ++s)
+        {
+            const SegmentedKernel::Segment& segment = k.segments_[s];
+            const SegmentedKernel::Shape& shape = k.shapes_[segment.shape];
+            const std::size_t offset = constantOffset;
+            constantOffset += segment.constants.size();
+            if (!shape.forwardKernel)
+                continue;
+
+            ForgeBufferHandle buffer = forwardBuffers_[segment.shape];
+            setLiveIns(buffer, shape.forwardLiveInIds, segment, width);
+            if (shape.constantsAsInputs)
+                setConstants(buffer, shape.forwardConstantIds, offset, width);
+            execute(shape.forwardKernel, buffer);
+            for (std::size_t j = 0; j < segment.liveOutSlots.size(); ++j)
+                forge_buffer_get_lanes(buffer, shape.forwardLiveOutIds[j], &values_[segment.liveOutSlots[j] * width]);
+        }
+    }
+
+    void setLiveIns(ForgeBufferHandle buffer, const std::vector<uint32_t>& ids,
+                    const SegmentedKernel::Segment& segment, std::size_t width)
+    {
+        for (std::size_t j = 0; j < segment.liveInSlots.size(); ++j)
+            forge_buffer_set_lanes(buffer, ids[j], &values_[segment.liveInSlots[j] * width]);
+    }
+
+    // Broadcast this segment's constants (a shared kernel reads them as inputs)
+    void setConstants(ForgeBufferHandle buffer, const std::vector<uint32_t>& ids, std::size_t offset,
+                      std::size_t width)
+    {
+        lanes_.resize(width);
+        for (std::size_t j = 0; j < ids.size(); ++j)
+        {
+            std::fill(lanes_.begin(), lanes_.begin() + width, kernel_->segmentConstants_[offset + j]);
+            forge_buffer_set_lanes(buffer, ids[j], lanes_.data());
+        }
+    }
+
+    bool hasNonZeroAdjoint(const SegmentedKernel::Segment& segment, std::size_t width) const
+    {
+        for (std::size_t j = 0; j < segment.liveOutSlots.size(); ++j)
+        {
+            const double* adj = &adjoints_[segment.liveOutSlots[j] * width];
+            for (std::size_t lane = 0; lane < width; ++lane)
+            {
+                if (adj[lane] != 0.0)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    void cleanup()
+    {
+        for (std::size_t k = 0; k < forwardBuffers_.size(); ++k)
+        {
+            if (forwardBuffers_[k])
+                forge_buffer_destroy(forwardBuffers_[k]);
+        }
+        for (std::size_t k = 0; k < gradientBuffers_.size(); ++k)
+        {
+            if (gradientBuffers_[k])
+                forge_buffer_destroy(gradientBuffers_[k]);
+        }
+        forwardBuffers_.clear();
+        gradientBuffers_.clear();
+    }
+
+    std::shared_ptr<const SegmentedKernel> kernel_;
+    std::vector<ForgeBufferHandle> forwardBuffers_;   // per shape
+    std::vector<ForgeBufferHandle> gradientBuffers_;  // per shape
+    std::vector<double> values_;                      // boundary values, slot-major
+    std::vector<double> adjoints_;                    // their adjoints
+    std::vector<double> lanes_;                       // scratch
+};
+
+}  // namespace forge
+}  // namespace xad
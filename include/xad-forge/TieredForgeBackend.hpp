@@ -0,0 +1,502 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  TieredForgeBackend - Interpreter -> Forge -> SIMD Forge tiered execution
+//
+//  This file is part of xad-forge, providing Forge JIT compilation
+//  as a backend for XAD automatic differentiation.
+//
+//  Whether compiling pays off depends on how often a graph is evaluated,
+//  which is often only known at runtime (see docs/benchmarks.md: the
+//  interpreter/tape wins below roughly 1K evaluations, JIT above). This
+//  backend starts on XAD's graph interpreter, measures how much time is
+//  spent there and promotes the graph to a compiled scalar kernel, and for
+//  bulk evaluation to a SIMD kernel, once a simple cost model predicts that
+//  the compilation will pay for itself.
+//
+//  Copyright (c) 2025 The xad-forge Authors
+//  https://github.com/da-roth/xad-forge
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <XAD/JITBackendInterface.hpp>
+#include <XAD/JITGraph.hpp>
+#include <XAD/JITGraphInterpreter.hpp>
+
+#include <xad-forge/CpuFeatures.hpp>
+#include <xad-forge/ForgeKernel.hpp>
+#include <xad-forge/KernelCache.hpp>
+
+// Forge C API - stable ABI
+#include <forge_c_api.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace xad
+{
+namespace forge
+{
+
+/**
+ * Parameters of the tiering cost model.
+ */
+struct TieringPolicy
+{
+    /// Predicted compile time per graph node (updated from measured compiles)
+    double compileNsPerNode;
+    /// Weight of each measured full compile in the moving average of
+    /// compileNsPerNode (1 = use the latest measurement only)
+    double compileCalibrationWeight;
+    /// Predicted speedup of the scalar Forge kernel over the interpreter
+    double scalarSpeedup;
+    /// Predicted speedup of the SIMD kernel over the scalar kernel, per lane
+    double vectorSpeedupPerLane;
+    /// Whether bulk evaluation may be promoted to a SIMD kernel
+    bool allowVectorTier;
+
+    TieringPolicy()
+        : compileNsPerNode(500.0)
+        , compileCalibrationWeight(0.5)
+        , scalarSpeedup(1.5)
+        , vectorSpeedupPerLane(0.7)
+        , allowVectorTier(true)
+    {
+    }
+};
+
+/**
+ * Tiered Backend - implements xad::JITBackend interface (vector width 1).
+ *
+ * Tiers:
+ *   Interpreter - xad::JITGraphInterpreter, no compile cost
+ *   Scalar      - Forge SSE2 scalar kernel
+ *   Vector      - Forge kernel for bestInstructionSet() (AVX2/AVX-512),
+ *                 used by the bulk evaluate() only
+ *
+ * Before each evaluation the next tier is considered. It is promoted to if
+ *   (a) the time already spent on the current tier reaches the predicted
+ *       compile time of the next tier - compiling then costs at most as much
+ *       as has already been spent, which bounds the total at twice the
+ *       optimum without knowing future evaluations; or
+ *   (b) for bulk evaluate(), the predicted saving over the known number of
+ *       paths exceeds the predicted compile time.
+ * Per-path times are measured; compile times are predicted from the node
+ * count and corrected after every compile that translated and compiled the
+ * graph from scratch. Every promotion is recorded in promotions() with the
+ * figures that led to it.
+ */
+template <class Scalar>
+class TieredForgeBackend : public xad::JITBackend<Scalar>
+{
+    static_assert(std::is_same<Scalar, double>::value,
+                  "TieredForgeBackend only supports double precision. Forge does not currently support float.");
+
+  public:
+    enum Tier
+    {
+        Interpreter = 0,
+        ScalarKernel = 1,
+        VectorKernel = 2
+    };
+
+    /// Record of one promotion decision
+    struct Promotion
+    {
+        Tier from;
+        Tier to;
+        std::size_t pathsOnTier;   ///< paths evaluated on the previous tier
+        double msOnTier;           ///< time spent on the previous tier
+        double nsPerPath;          ///< measured cost per path on the previous tier
+        double predictedCompileMs;
+        double actualCompileMs;
+        std::string reason;
+    };
+
+    explicit TieredForgeBackend(const TieringPolicy& policy = TieringPolicy(), bool useGraphOptimizations = false)
+        : policy_(policy)
+        , useOptimizations_(useGraphOptimizations)
+        , cache_(nullptr)
+        , tier_(Interpreter)
+        , vectorInstructionSet_(bestInstructionSet())
+    {
+        clearStatistics();
+    }
+
+    ~TieredForgeBackend() override {}
+
+    // No copy
+    TieredForgeBackend(const TieredForgeBackend&) = delete;
+    TieredForgeBackend& operator=(const TieredForgeBackend&) = delete;
+
+    //=========================================================================
+    // JITBackend interface implementation
+    //=========================================================================
+
+    /**
+     * Prepare the interpreter tier. Nothing is compiled yet.
+     * The graph is copied, as later promotions compile from it.
+     */
+    void compile(const xad::JITGraph& jitGraph) override
+    {
+        reset();
+        graph_.reset(new xad::JITGraph(jitGraph));
+        interpreter_.compile(*graph_);
+        inputs_.assign(graph_->input_ids.size(), Scalar(0));
+        outputScratch_.resize(graph_->output_ids.size());
+        gradientScratch_.resize(graph_->input_ids.size());
+    }
+
+    void reset() override
+    {
+        interpreter_.reset();
+        graph_.reset();
+        scalarBuffer_ = ForgeBuffer();
+        vectorBuffer_ = ForgeBuffer();
+        tier_ = Interpreter;
+        clearStatistics();
+        promotions_.clear();
+        inputs_.clear();
+    }
+
+    std::size_t vectorWidth() const override { return 1; }
+    std::size_t numInputs() const override { return graph_ ? graph_->input_ids.size() : 0; }
+    std::size_t numOutputs() const override { return graph_ ? graph_->output_ids.size() : 0; }
+
+    void setInput(std::size_t inputIndex, const Scalar* values) override
+    {
+        if (inputIndex >= numInputs())
+            throw std::runtime_error("Input index out of range");
+        inputs_[inputIndex] = values[0];
+        if (scalarBuffer_.valid())
+            scalarBuffer_.setInput(inputIndex, values);
+        else
+            interpreter_.setInput(inputIndex, values);
+    }
+
+    void forward(Scalar* outputs) override
+    {
+        run(outputs, nullptr);
+    }
+
+    void forwardAndBackward(Scalar* outputs, Scalar* inputGradients) override
+    {
+        run(outputs, inputGradients);
+    }
+
+    // =========================================================================
+    // Bulk evaluation
+    // =========================================================================
+
+    /**
+     * Evaluate numPaths paths in structure-of-arrays layout, as
+     * ForgeBackendAVX::evaluate(). The known path count enters the cost model,
+     * so a large batch may be promoted to a compiled tier up front.
+     * If gradientsSoA is null, only outputs are computed.
+     */
+    void evaluate(std::size_t numPaths, const Scalar* inputsSoA, Scalar* outputsSoA, Scalar* gradientsSoA = nullptr)
+    {
+        if (!graph_)
+            throw std::runtime_error("Backend not compiled");
+
+        std::size_t done = 0;
+        while (done < numPaths)
+        {
+            std::size_t count = numPaths - done;
+            promoteIfProfitable(count);
+
+            // Without a measurement on the current tier, run a short probe
+            // first so that the next decision has a per-path cost to work with
+            if (paths_[tier_] == 0 && tier_ != topTier() && count > PROBE_PATHS)
+                count = PROBE_PATHS;
+
+            const Clock::time_point start = Clock::now();
+            evaluateOnTier(done, count, numPaths, inputsSoA, outputsSoA, gradientsSoA);
+            record(count, start);
+            done += count;
+        }
+    }
+
+    // =========================================================================
+    // Inspection
+    // =========================================================================
+
+    Tier tier() const { return tier_; }
+    const std::vector<Promotion>& promotions() const { return promotions_; }
+    const TieringPolicy& policy() const { return policy_; }
+
+    /// Paths evaluated and time spent (ms) on a tier since compile()
+    std::size_t pathsOnTier(Tier tier) const { return paths_[tier]; }
+    double msOnTier(Tier tier) const { return ns_[tier] * 1e-6; }
+
+    /**
+     * Compile promoted tiers through a kernel cache. The cache must outlive
+     * this backend.
+     */
+    void setKernelCache(KernelCache* cache) { cache_ = cache; }
+
+    /**
+     * Promote to a tier immediately, regardless of the cost model.
+     */
+    void promoteTo(Tier target)
+    {
+        if (!graph_)
+            throw std::runtime_error("Backend not compiled");
+        while (tier_ < std::min(target, topTier()))
+            promote(nextTier(), 0.0, "forced");
+    }
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    static const std::size_t PROBE_PATHS = 8;
+
+    Tier topTier() const
+    {
+        const bool vectorAvailable =
+            policy_.allowVectorTier && ForgeKernel::vectorWidthFor(vectorInstructionSet_) > 1;
+        return vectorAvailable ? VectorKernel : ScalarKernel;
+    }
+
+    Tier nextTier() const { return static_cast<Tier>(tier_ + 1); }
+
+    double nsPerPath(Tier tier) const { return paths_[tier] ? ns_[tier] / paths_[tier] : 0.0; }
+
+    double speedupOf(Tier tier) const
+    {
+        if (tier == ScalarKernel)
+            return policy_.scalarSpeedup;
+        return policy_.vectorSpeedupPerLane * static_cast<double>(ForgeKernel::vectorWidthFor(vectorInstructionSet_));
+    }
+
+    double predictedCompileNs() const
+    {
+        return policy_.compileNsPerNode * static_cast<double>(graph_->nodeCount() + graph_->const_pool.size());
+    }
+
+    // Single evaluations only ever use the scalar kernel
+    void run(Scalar* outputs, Scalar* inputGradients)
+    {
+        if (!graph_)
+            throw std::runtime_error("Backend not compiled");
+        if (tier_ == Interpreter)
+            promoteIfProfitable(1);
+
+        const Clock::time_point start = Clock::now();
+        if (scalarBuffer_.valid())
+        {
+            if (inputGradients)
+                scalarBuffer_.forwardAndBackward(outputs, inputGradients);
+            else
+                scalarBuffer_.forward(outputs);
+        }
+        else
+        {
+            if (inputGradients)
+                interpreter_.forwardAndBackward(outputs, inputGradients);
+            else
+                interpreter_.forward(outputs);
+        }
+        record(1, start, scalarBuffer_.valid() ? ScalarKernel : Interpreter);
+    }
+
+    void promoteIfProfitable(std::size_t upcomingPaths)
+    {
+        while (tier_ < topTier())
+        {
+            const Tier next = nextTier();
+            const double compileNs = predictedCompileNs();
+            const double saving =
+                static_cast<double>(upcomingPaths) * nsPerPath(tier_) * (1.0 - 1.0 / speedupOf(next));
+
+            if (ns_[tier_] >= compileNs)
+                promote(next, compileNs, "time on tier reached predicted compile time");
+            else if (saving >= compileNs)
+                promote(next, compileNs, "predicted saving over upcoming paths exceeds compile time");
+            else
+                break;
+        }
+    }
+
+    void promote(Tier next, double predictedNs, const char* reason)
+    {
+        Promotion p;
+        p.from = tier_;
+        p.to = next;
+        p.pathsOnTier = paths_[tier_];
+        p.msOnTier = ns_[tier_] * 1e-6;
+        p.nsPerPath = nsPerPath(tier_);
+        p.predictedCompileMs = predictedNs * 1e-6;
+        p.reason = reason;
+
+        const Clock::time_point start = Clock::now();
+        const ForgeInstructionSet isa = next == ScalarKernel ? FORGE_INSTRUCTION_SET_SSE2_SCALAR : vectorInstructionSet_;
+        std::shared_ptr<const ForgeKernel> kernel;
+        bool fullCompile = true;
+        if (cache_)
+        {
+            kernel = cache_->getOrCompile(*graph_, isa, useOptimizations_, std::vector<std::size_t>(), &fullCompile);
+        }
+        else if (scalarBuffer_.valid())
+        {
+            kernel = ForgeKernel::compile(scalarBuffer_.kernel()->graph(), isa, useOptimizations_);  // reuse translation
+            fullCompile = false;
+        }
+        else
+        {
+            kernel = ForgeKernel::compile(*graph_, isa, useOptimizations_);
+        }
+        const double compileNs = elapsedNs(start);
+        p.actualCompileMs = compileNs * 1e-6;
+
+        if (next == ScalarKernel)
+        {
+            scalarBuffer_ = ForgeBuffer(kernel);
+            for (std::size_t i = 0; i < inputs_.size(); ++i)
+                scalarBuffer_.setInput(i, &inputs_[i]);
+        }
+        else
+        {
+            vectorBuffer_ = ForgeBuffer(kernel);
+        }
+
+        // Correct the compile-time model with full compiles only: a cache hit
+        // or a compile reusing the translation is cheaper than what is predicted
+        const double nodes = static_cast<double>(graph_->nodeCount() + graph_->const_pool.size());
+        if (fullCompile && nodes > 0)
+            policy_.compileNsPerNode += policy_.compileCalibrationWeight * (compileNs / nodes - policy_.compileNsPerNode);
+
+        tier_ = next;
+        promotions_.push_back(p);
+    }
+
+    void evaluateOnTier(std::size_t first, std::size_t count, std::size_t numPaths, const Scalar* inputsSoA,
+                        Scalar* outputsSoA, Scalar* gradientsSoA)
+    {
+        const std::size_t nIn = numInputs();
+        const std::size_t nOut = numOutputs();
+
+        if (tier_ == VectorKernel || tier_ == ScalarKernel)
+        {
+            // ForgeBuffer::evaluate works on contiguous SoA rows; gather the
+            // slice [first, first + count) unless it is the whole batch
+            ForgeBuffer& buffer = tier_ == VectorKernel ? vectorBuffer_ : scalarBuffer_;
+            if (first == 0 && count == numPaths)
+            {
+                buffer.evaluate(count, inputsSoA, outputsSoA, gradientsSoA);
+                return;
+            }
+            sliceIn_.resize(nIn * count);
+            sliceOut_.resize(nOut * count);
+            sliceGrad_.resize(gradientsSoA ? nIn * count : 0);
+            for (std::size_t i = 0; i < nIn; ++i)
+                std::copy(inputsSoA + i * numPaths + first, inputsSoA + i * numPaths + first + count,
+                          sliceIn_.begin() + i * count);
+            buffer.evaluate(count, sliceIn_.data(), sliceOut_.data(), gradientsSoA ? sliceGrad_.data() : nullptr);
+            for (std::size_t o = 0; o < nOut; ++o)
+                std::copy(sliceOut_.begin() + o * count, sliceOut_.begin() + (o + 1) * count,
+                          outputsSoA + o * numPaths + first);
+            if (gradientsSoA)
+            {
+                for (std::size_t i = 0; i < nIn; ++i)
+                    std::copy(sliceGrad_.begin() + i * count, sliceGrad_.begin() + (i + 1) * count,
+                              gradientsSoA + i * numPaths + first);
+            }
+            return;
+        }
+
+        for (std::size_t p = first; p < first + count; ++p)
+        {
+            for (std::size_t i = 0; i < nIn; ++i)
+                interpreter_.setInput(i, inputsSoA + i * numPaths + p);
+            if (gradientsSoA)
+                interpreter_.forwardAndBackward(outputScratch_.data(), gradientScratch_.data());
+            else
+                interpreter_.forward(outputScratch_.data());
+            for (std::size_t o = 0; o < nOut; ++o)
+                outputsSoA[o * numPaths + p] = outputScratch_[o];
+            if (gradientsSoA)
+            {
+                for (std::size_t i = 0; i < nIn; ++i)
+                    gradientsSoA[i * numPaths + p] = gradientScratch_[i];
+            }
+        }
+
+        // Restore the single-evaluation inputs on the interpreter
+        for (std::size_t i = 0; i < nIn; ++i)
+            interpreter_.setInput(i, &inputs_[i]);
+    }
+
+    void clearStatistics()
+    {
+        for (int t = 0; t < 3; ++t)
+        {
+            paths_[t] = 0;
+            ns_[t] = 0.0;
+        }
+    }
+
+    void record(std::size_t paths, Clock::time_point start)
+    {
+        record(paths, start, tier_);
+    }
+
+    void record(std::size_t paths, Clock::time_point start, Tier tier)
+    {
+        paths_[tier] += paths;
+        ns_[tier] += elapsedNs(start);
+    }
+
+    static double elapsedNs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    TieringPolicy policy_;
+    bool useOptimizations_;
+    KernelCache* cache_;  // not owned, may be null
+
+    std::unique_ptr<xad::JITGraph> graph_;  // copy, compiled on promotion
+    xad::JITGraphInterpreter<Scalar> interpreter_;
+    ForgeBuffer scalarBuffer_;
+    ForgeBuffer vectorBuffer_;
+
+    Tier tier_;
+    ForgeInstructionSet vectorInstructionSet_;
+    std::size_t paths_[3];
+    double ns_[3];
+    std::vector<Promotion> promotions_;
+
+    std::vector<Scalar> inputs_;  // current single-evaluation inputs
+    std::vector<Scalar> outputScratch_;
+    std::vector<Scalar> gradientScratch_;
+    std::vector<Scalar> sliceIn_;
+    std::vector<Scalar> sliceOut_;
+    std::vector<Scalar> sliceGrad_;
+};
+
+}  // namespace forge
+}  // namespace xad
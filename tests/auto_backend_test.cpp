@@ -0,0 +1,180 @@
+/*
+ * xad-forge Auto Backend Test Suite
+ *
+ * Tests the ForgeBackendAuto runtime instruction set dispatch:
+ * - The chosen instruction set matches the host CPU
+ * - Results are correct at whatever vector width was chosen
+ * - An explicitly requested scalar instruction set is honoured
+ * - One graph translation compiles for several instruction sets
+ *
+ * Copyright (c) 2025 The xad-forge Authors
+ * https://github.com/da-roth/xad-forge
+ * SPDX-License-Identifier: Zlib
+ */
+
+#include <xad-forge/CpuFeatures.hpp>
+#include <xad-forge/ForgeBackendAuto.hpp>
+#include <xad-forge/ForgeGraph.hpp>
+#include <XAD/XAD.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include <memory>
+
+class AutoBackendTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        // f(x, y) = x*y + x^2, df/dx = y + 2x, df/dy = x
+        xad::AD x(1.0), y(2.0);
+        jit.registerInput(x);
+        jit.registerInput(y);
+        jit.newRecording();
+        xad::AD z = x * y + x * x;
+        jit.registerOutput(z);
+    }
+
+    xad::JITCompiler<double, 1> jit;
+};
+
+TEST_F(AutoBackendTest, ChoosesWidestSupportedInstructionSet)
+{
+    xad::forge::ForgeBackendAuto<double> backend;
+
+    const xad::forge::CpuFeatures& cpu = xad::forge::CpuFeatures::host();
+    EXPECT_EQ(xad::forge::bestInstructionSet(), backend.instructionSet());
+    EXPECT_TRUE(xad::forge::hostSupports(backend.instructionSet()));
+    if (cpu.avx2)
+        EXPECT_GE(backend.vectorWidth(), 4u);
+    else
+        EXPECT_EQ(1u, backend.vectorWidth());
+
+    // The width is known before compiling and does not change afterwards
+    const std::size_t width = backend.vectorWidth();
+    backend.compile(jit.getGraph());
+    EXPECT_EQ(width, backend.vectorWidth());
+    EXPECT_EQ(static_cast<int>(width), backend.getVectorWidth());
+}
+
+TEST_F(AutoBackendTest, BatchedResultsAtChosenWidth)
+{
+    xad::forge::ForgeBackendAuto<double> backend;
+    backend.compile(jit.getGraph());
+    const std::size_t width = backend.vectorWidth();
+
+    std::vector<double> xs(width), ys(width);
+    for (std::size_t i = 0; i < width; ++i)
+    {
+        xs[i] = 0.5 * static_cast<double>(i) - 1.0;
+        ys[i] = 2.0 - 0.25 * static_cast<double>(i);
+    }
+    backend.setInput(0, xs.data());
+    backend.setInput(1, ys.data());
+
+    std::vector<double> outputs(width), gradients(2 * width);
+    backend.forwardAndBackward(outputs.data(), gradients.data());
+
+    for (std::size_t i = 0; i < width; ++i)
+    {
+        EXPECT_NEAR(xs[i] * ys[i] + xs[i] * xs[i], outputs[i], 1e-10) << "Output mismatch at lane " << i;
+        EXPECT_NEAR(ys[i] + 2.0 * xs[i], gradients[i], 1e-10) << "dx mismatch at lane " << i;
+        EXPECT_NEAR(xs[i], gradients[width + i], 1e-10) << "dy mismatch at lane " << i;
+    }
+}
+
+TEST_F(AutoBackendTest, BulkEvaluate)
+{
+    const std::size_t numPaths = 13;
+
+    xad::forge::ForgeBackendAuto<double> backend;
+    backend.compile(jit.getGraph());
+
+    std::vector<double> inputs(2 * numPaths);
+    for (std::size_t p = 0; p < numPaths; ++p)
+    {
+        inputs[p] = 0.25 * static_cast<double>(p) - 1.0;
+        inputs[numPaths + p] = 2.0 - 0.5 * static_cast<double>(p);
+    }
+
+    std::vector<double> outputs(numPaths), gradients(2 * numPaths);
+    backend.evaluate(numPaths, inputs.data(), outputs.data(), gradients.data());
+
+    for (std::size_t p = 0; p < numPaths; ++p)
+    {
+        double x = inputs[p], y = inputs[numPaths + p];
+        EXPECT_NEAR(x * y + x * x, outputs[p], 1e-10) << "Output mismatch at path " << p;
+        EXPECT_NEAR(y + 2.0 * x, gradients[p], 1e-10) << "dx mismatch at path " << p;
+        EXPECT_NEAR(x, gradients[numPaths + p], 1e-10) << "dy mismatch at path " << p;
+    }
+}
+
+TEST_F(AutoBackendTest, ExplicitScalarInstructionSet)
+{
+    xad::forge::ForgeBackendAuto<double> backend(FORGE_INSTRUCTION_SET_SSE2_SCALAR);
+    EXPECT_EQ(1u, backend.vectorWidth());
+
+    backend.compile(jit.getGraph());
+
+    double x = 3.0, y = -2.0;
+    backend.setInput(0, &x);
+    backend.setInput(1, &y);
+
+    double output = 0.0;
+    double gradients[2] = {0.0, 0.0};
+    backend.forwardAndBackward(&output, gradients);
+
+    EXPECT_NEAR(x * y + x * x, output, 1e-10);
+    EXPECT_NEAR(y + 2.0 * x, gradients[0], 1e-10);
+    EXPECT_NEAR(x, gradients[1], 1e-10);
+}
+
+TEST_F(AutoBackendTest, OneTranslationForSeveralInstructionSets)
+{
+    std::shared_ptr<const xad::forge::ForgeGraph> graph = xad::forge::ForgeGraph::translate(jit.getGraph());
+    EXPECT_EQ(2u, graph->numInputs());
+    EXPECT_EQ(1u, graph->numOutputs());
+
+    std::vector<ForgeInstructionSet> isas;
+    isas.push_back(FORGE_INSTRUCTION_SET_SSE2_SCALAR);
+    isas.push_back(xad::forge::bestInstructionSet());
+
+    for (bool parallel : {false, true})
+    {
+        std::vector<std::shared_ptr<const xad::forge::ForgeKernel>> kernels =
+            xad::forge::ForgeKernel::compileAll(graph, isas, false, parallel);
+        ASSERT_EQ(isas.size(), kernels.size());
+
+        for (std::size_t k = 0; k < kernels.size(); ++k)
+        {
+            ASSERT_TRUE(kernels[k]);
+            EXPECT_EQ(graph, kernels[k]->graph()) << "translation must be shared";
+            EXPECT_EQ(isas[k], kernels[k]->instructionSet());
+
+            xad::forge::ForgeBackendAuto<double> backend(kernels[k]);
+            const std::size_t width = backend.vectorWidth();
+            std::vector<double> xs(width), ys(width);
+            for (std::size_t i = 0; i < width; ++i)
+            {
+                xs[i] = 1.5 - 0.5 * static_cast<double>(i);
+                ys[i] = 0.25 * static_cast<double>(i) + 1.0;
+            }
+            backend.setInput(0, xs.data());
+            backend.setInput(1, ys.data());
+
+            std::vector<double> outputs(width), gradients(2 * width);
+            backend.forwardAndBackward(outputs.data(), gradients.data());
+            for (std::size_t i = 0; i < width; ++i)
+            {
+                EXPECT_NEAR(xs[i] * ys[i] + xs[i] * xs[i], outputs[i], 1e-10) << "kernel " << k << ", lane " << i;
+                EXPECT_NEAR(ys[i] + 2.0 * xs[i], gradients[i], 1e-10) << "kernel " << k << ", lane " << i;
+                EXPECT_NEAR(xs[i], gradients[width + i], 1e-10) << "kernel " << k << ", lane " << i;
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,20 +1,33 @@
 /*
  * xad-forge AVX Backend Test Suite
  *
- * Tests the ForgeBackendAVX with re-evaluation pattern:
+ * Tests the packed backends ForgeBackendAVX and ForgeBackendAVX512 with
+ * re-evaluation pattern, as typed tests run once per backend:
  * - Compile once, evaluate multiple times with different inputs
- * - Tests parallel evaluation with AVX2 (4 evaluations per call)
+ * - Tests parallel evaluation with AVX2 (4 evaluations per call) and
+ *   AVX-512 (8 evaluations per call)
  * - Tests forward pass and adjoint computation
+ * - Tests setting all inputs in one call
+ * - Tests that bulk evaluation leaves all kernel variants with the same inputs
+ * - Tests vector-Jacobian products with per-lane output adjoints
+ *
+ * The AVX-512 tests are only built when the Forge C API supports AVX-512
+ * (XAD_FORGE_HAS_AVX512). Tests are skipped on hosts without the backend's
+ * instruction set.
  *
  * Copyright (c) 2025 The xad-forge Authors
  * https://github.com/da-roth/xad-forge
  * SPDX-License-Identifier: Zlib
  */
 
+#include <xad-forge/CpuFeatures.hpp>
 #include <xad-forge/ForgeBackendAVX.hpp>
+#include <xad-forge/ForgeBackendAVX512.hpp>
 #include <XAD/XAD.hpp>
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <cmath>
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -62,14 +75,46 @@ double f4ABool_double(double x)
     return (x < 2.0) ? 2.0 * x : 10.0 * x;
 }
 
+// Host requirement and test name of each packed backend; the number of
+// parallel evaluations per call is the backend's VECTOR_WIDTH
+template <class Backend>
+struct PackedBackendTraits;
+
+template <>
+struct PackedBackendTraits<xad::forge::ForgeBackendAVX<double>>
+{
+    static ForgeInstructionSet instructionSet() { return FORGE_INSTRUCTION_SET_AVX2_PACKED; }
+    static std::string name() { return "AVX2"; }
+};
+
+#if XAD_FORGE_HAS_AVX512
+template <>
+struct PackedBackendTraits<xad::forge::ForgeBackendAVX512<double>>
+{
+    static ForgeInstructionSet instructionSet() { return FORGE_INSTRUCTION_SET_AVX512_PACKED; }
+    static std::string name() { return "AVX512"; }
+};
+#endif
+
+struct PackedBackendNames
+{
+    template <class Backend>
+    static std::string GetName(int)
+    {
+        return PackedBackendTraits<Backend>::name();
+    }
+};
+
 } // anonymous namespace
 
+template <class Backend>
 class AVXBackendTest : public ::testing::Test {
 protected:
-    /// Number of parallel evaluations per call (4 for AVX2)
-    static constexpr int BATCH_SIZE = xad::forge::ForgeBackendAVX<double>::VECTOR_WIDTH;
-
-    void SetUp() override {}
+    void SetUp() override
+    {
+        if (!xad::forge::hostSupports(PackedBackendTraits<Backend>::instructionSet()))
+            GTEST_SKIP() << "Host CPU does not support " << PackedBackendTraits<Backend>::name();
+    }
     void TearDown() override {}
 
     // Helper to get reference values using XAD Tape
@@ -95,18 +140,26 @@ protected:
 
 };
 
+#if XAD_FORGE_HAS_AVX512
+typedef ::testing::Types<xad::forge::ForgeBackendAVX<double>, xad::forge::ForgeBackendAVX512<double>> PackedBackends;
+#else
+typedef ::testing::Types<xad::forge::ForgeBackendAVX<double>> PackedBackends;
+#endif
+TYPED_TEST_SUITE(AVXBackendTest, PackedBackends, PackedBackendNames);
+
 // =============================================================================
-// Basic AVX backend tests with parallel evaluation (4 per call)
+// Basic AVX backend tests with parallel evaluation (VECTOR_WIDTH per call)
 // =============================================================================
 
-TEST_F(AVXBackendTest, LinearFunctionBatched)
+TYPED_TEST(AVXBackendTest, LinearFunctionBatched)
 {
-    // 8 inputs = 2 batches of 4
+    constexpr int BATCH_SIZE = TypeParam::VECTOR_WIDTH;
+    // 8 inputs = 2 batches of 4 on AVX2, 1 batch of 8 on AVX-512
     std::vector<double> inputs = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0};
 
     // Reference values
     std::vector<double> refOutputs, refDerivatives;
-    computeReference(f1<xad::AD>, inputs, refOutputs, refDerivatives);
+    this->computeReference(f1<xad::AD>, inputs, refOutputs, refDerivatives);
 
     // Build JIT graph using JITCompiler
     xad::JITCompiler<double, 1> jit;
@@ -117,13 +170,13 @@ TEST_F(AVXBackendTest, LinearFunctionBatched)
     jit.registerOutput(y);
 
     // Compile AVX backend from JIT graph
-    xad::forge::ForgeBackendAVX<double> avx;
+    TypeParam avx;
     avx.compile(jit.getGraph());
 
-    // Process in batches of 4
+    // Process in batches of BATCH_SIZE
     for (std::size_t batch = 0; batch < inputs.size(); batch += BATCH_SIZE)
     {
-        // Set 4 input values (one per parallel evaluation)
+        // Set BATCH_SIZE input values (one per parallel evaluation)
         double inputBatch[BATCH_SIZE];
         for (int i = 0; i < BATCH_SIZE; ++i)
             inputBatch[i] = inputs[batch + i];
@@ -134,7 +187,7 @@ TEST_F(AVXBackendTest, LinearFunctionBatched)
         double inputGradients[BATCH_SIZE];
         avx.forwardAndBackward(outputs, inputGradients);
 
-        // Verify all 4 results
+        // Verify all BATCH_SIZE results
         for (int i = 0; i < BATCH_SIZE; ++i)
         {
             std::size_t idx = batch + i;
@@ -146,12 +199,13 @@ TEST_F(AVXBackendTest, LinearFunctionBatched)
     }
 }
 
-TEST_F(AVXBackendTest, QuadraticFunctionBatched)
+TYPED_TEST(AVXBackendTest, QuadraticFunctionBatched)
 {
+    constexpr int BATCH_SIZE = TypeParam::VECTOR_WIDTH;
     std::vector<double> inputs = {1.0, 2.0, 3.0, 4.0, -1.0, -2.0, 0.5, 1.5};
 
     std::vector<double> refOutputs, refDerivatives;
-    computeReference(f2<xad::AD>, inputs, refOutputs, refDerivatives);
+    this->computeReference(f2<xad::AD>, inputs, refOutputs, refDerivatives);
 
     // Build graph using JITCompiler
     xad::JITCompiler<double, 1> jit;
@@ -161,7 +215,7 @@ TEST_F(AVXBackendTest, QuadraticFunctionBatched)
     xad::AD y = f2(x);
     jit.registerOutput(y);
 
-    xad::forge::ForgeBackendAVX<double> avx;
+    TypeParam avx;
     avx.compile(jit.getGraph());
 
     for (std::size_t batch = 0; batch < inputs.size(); batch += BATCH_SIZE)
@@ -186,13 +240,14 @@ TEST_F(AVXBackendTest, QuadraticFunctionBatched)
     }
 }
 
-TEST_F(AVXBackendTest, MathFunctionsBatched)
+TYPED_TEST(AVXBackendTest, MathFunctionsBatched)
 {
+    constexpr int BATCH_SIZE = TypeParam::VECTOR_WIDTH;
     // Positive inputs for log/sqrt
     std::vector<double> inputs = {1.0, 2.0, 3.0, 4.0, 0.5, 1.5, 2.5, 3.5};
 
     std::vector<double> refOutputs, refDerivatives;
-    computeReference(f3<xad::AD>, inputs, refOutputs, refDerivatives);
+    this->computeReference(f3<xad::AD>, inputs, refOutputs, refDerivatives);
 
     // Build graph using JITCompiler
     xad::JITCompiler<double, 1> jit;
@@ -202,7 +257,7 @@ TEST_F(AVXBackendTest, MathFunctionsBatched)
     xad::AD y = f3(x);
     jit.registerOutput(y);
 
-    xad::forge::ForgeBackendAVX<double> avx;
+    TypeParam avx;
     avx.compile(jit.getGraph());
 
     for (std::size_t batch = 0; batch < inputs.size(); batch += BATCH_SIZE)
@@ -227,8 +282,9 @@ TEST_F(AVXBackendTest, MathFunctionsBatched)
     }
 }
 
-TEST_F(AVXBackendTest, ABoolBranchingBatched)
+TYPED_TEST(AVXBackendTest, ABoolBranchingBatched)
 {
+    constexpr int BATCH_SIZE = TypeParam::VECTOR_WIDTH;
     // Mix of values < 2 and >= 2 to test both branches
     std::vector<double> inputs = {1.0, 3.0, 0.5, 2.5, -1.0, 5.0, 1.5, 4.0};
 
@@ -258,7 +314,7 @@ TEST_F(AVXBackendTest, ABoolBranchingBatched)
     xad::AD y = f4ABool(x);
     jit.registerOutput(y);
 
-    xad::forge::ForgeBackendAVX<double> avx;
+    TypeParam avx;
     avx.compile(jit.getGraph());
 
     for (std::size_t batch = 0; batch < inputs.size(); batch += BATCH_SIZE)
@@ -290,8 +346,9 @@ TEST_F(AVXBackendTest, ABoolBranchingBatched)
 // Re-evaluation tests (compile once, run many batches)
 // =============================================================================
 
-TEST_F(AVXBackendTest, ReEvaluateManyBatches)
+TYPED_TEST(AVXBackendTest, ReEvaluateManyBatches)
 {
+    constexpr int BATCH_SIZE = TypeParam::VECTOR_WIDTH;
     // Build graph using JITCompiler
     xad::JITCompiler<double, 1> jit;
     xad::AD x(1.0);
@@ -301,14 +358,14 @@ TEST_F(AVXBackendTest, ReEvaluateManyBatches)
     jit.registerOutput(y);
 
     // Compile once
-    xad::forge::ForgeBackendAVX<double> avx;
+    TypeParam avx;
     avx.compile(jit.getGraph());
 
-    // Run 100 batches (400 evaluations)
+    // Run 100 batches (100 * BATCH_SIZE evaluations)
     const int NUM_BATCHES = 100;
     for (int batch = 0; batch < NUM_BATCHES; ++batch)
     {
-        // Generate 4 different inputs per batch
+        // Generate BATCH_SIZE different inputs per batch
         double inputBatch[BATCH_SIZE];
         for (int i = 0; i < BATCH_SIZE; ++i)
         {
@@ -337,12 +394,13 @@ TEST_F(AVXBackendTest, ReEvaluateManyBatches)
 // Two-input function with AVX
 // =============================================================================
 
-TEST_F(AVXBackendTest, TwoInputFunctionBatched)
+TYPED_TEST(AVXBackendTest, TwoInputFunctionBatched)
 {
+    constexpr int BATCH_SIZE = TypeParam::VECTOR_WIDTH;
     // f(x, y) = x*y + x^2
     // df/dx = y + 2x, df/dy = x
 
-    // 4 pairs of (x, y) per batch
+    // BATCH_SIZE pairs of (x, y) per batch
     std::vector<std::pair<double, double>> inputs = {
         {1.0, 2.0}, {2.0, 3.0}, {3.0, 1.0}, {0.5, 4.0},
         {-1.0, 2.0}, {2.0, -1.0}, {1.5, 1.5}, {3.0, 3.0}
@@ -380,7 +438,7 @@ TEST_F(AVXBackendTest, TwoInputFunctionBatched)
     xad::AD z = x * y + x * x;
     jit.registerOutput(z);
 
-    xad::forge::ForgeBackendAVX<double> avx;
+    TypeParam avx;
     avx.compile(jit.getGraph());
 
     ASSERT_EQ(2u, avx.numInputs());
@@ -398,7 +456,7 @@ TEST_F(AVXBackendTest, TwoInputFunctionBatched)
         avx.setInput(1, yBatch);
 
         double outputs[BATCH_SIZE];
-        double inputGradients[2 * BATCH_SIZE];  // 2 inputs x 4 evaluations
+        double inputGradients[2 * BATCH_SIZE];  // 2 inputs x BATCH_SIZE evaluations
         avx.forwardAndBackward(outputs, inputGradients);
 
         for (int i = 0; i < BATCH_SIZE; ++i)
@@ -414,13 +472,375 @@ TEST_F(AVXBackendTest, TwoInputFunctionBatched)
     }
 }
 
+TYPED_TEST(AVXBackendTest, SetInputsMatchesSetInput)
+{
+    constexpr int BATCH_SIZE = TypeParam::VECTOR_WIDTH;
+    // f(x, y) = x*y + x^2, with many inputs set and gathered in bulk
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0), y(2.0);
+    jit.registerInput(x);
+    jit.registerInput(y);
+    jit.newRecording();
+    xad::AD z = x * y + x * x;
+    jit.registerOutput(z);
+
+    TypeParam single, bulk;
+    single.compile(jit.getGraph());
+    bulk.compile(jit.getGraph());
+
+    // Input-major: x in all lanes, then y in all lanes
+    double values[2 * BATCH_SIZE];
+    for (int i = 0; i < BATCH_SIZE; ++i)
+    {
+        values[i] = 0.75 * i - 0.5;
+        values[BATCH_SIZE + i] = 2.0 - 0.5 * i;
+    }
+    single.setInput(0, values);
+    single.setInput(1, values + BATCH_SIZE);
+    bulk.setInputs(values);
+
+    double out1[BATCH_SIZE], out2[BATCH_SIZE], grad1[2 * BATCH_SIZE], grad2[2 * BATCH_SIZE];
+    single.forwardAndBackward(out1, grad1);
+    bulk.forwardAndBackward(out2, grad2);
+    for (int i = 0; i < BATCH_SIZE; ++i)
+    {
+        EXPECT_EQ(out1[i], out2[i]);
+        EXPECT_NEAR(values[BATCH_SIZE + i] + 2.0 * values[i], grad2[i], 1e-12);
+        EXPECT_NEAR(values[i], grad2[BATCH_SIZE + i], 1e-12);
+    }
+    for (int i = 0; i < 2 * BATCH_SIZE; ++i)
+        EXPECT_EQ(grad1[i], grad2[i]);
+
+    // Also after the forward-only buffer exists
+    bulk.forward(out2);
+    double next[2 * BATCH_SIZE];
+    for (int i = 0; i < BATCH_SIZE; ++i)
+    {
+        next[i] = 0.5;
+        next[BATCH_SIZE + i] = 1.0 + i;
+    }
+    bulk.setInputs(next);
+    bulk.forward(out2);
+    for (int i = 0; i < BATCH_SIZE; ++i)
+        EXPECT_NEAR(0.5 * next[BATCH_SIZE + i] + 0.25, out2[i], 1e-12);
+}
+
+TYPED_TEST(AVXBackendTest, BulkEvaluationKeepsInputsConsistent)
+{
+    constexpr int BATCH_SIZE = TypeParam::VECTOR_WIDTH;
+    // f(x, y) = x*y + x^2
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0), y(2.0);
+    jit.registerInput(x);
+    jit.registerInput(y);
+    jit.newRecording();
+    xad::AD z = x * y + x * x;
+    jit.registerOutput(z);
+
+    TypeParam backend;
+    backend.compile(jit.getGraph());
+
+    double first[2 * BATCH_SIZE];
+    for (int i = 0; i < BATCH_SIZE; ++i)
+    {
+        first[i] = 0.75 * i - 0.5;
+        first[BATCH_SIZE + i] = 2.0 - 0.5 * i;
+    }
+    double outputs[BATCH_SIZE], forwardOutputs[BATCH_SIZE], gradients[2 * BATCH_SIZE];
+    backend.setInputs(first);
+    backend.forward(forwardOutputs);  // creates the forward-only buffer
+
+    // Writes the forward+backward buffer only; the forward-only kernel must
+    // still see the same inputs afterwards, also after setting one of them
+    const std::size_t numPaths = 6;
+    const double inputsSoA[2 * numPaths] = {0.5, 1.5, 2.5, 3.5, 4.5, 5.5, -1.0, -2.0, -3.0, -4.0, -5.0, -6.0};
+    double outputsSoA[numPaths], gradientsSoA[2 * numPaths];
+    backend.evaluate(numPaths, inputsSoA, outputsSoA, gradientsSoA);
+
+    double x0[BATCH_SIZE];
+    for (int lane = 0; lane < BATCH_SIZE; ++lane)
+        x0[lane] = 0.25 + 0.5 * lane;
+    backend.setInput(0, x0);
+    backend.forwardAndBackward(outputs, gradients);
+    backend.forward(forwardOutputs);
+    for (int lane = 0; lane < BATCH_SIZE; ++lane)
+        EXPECT_EQ(outputs[lane], forwardOutputs[lane]) << "lane " << lane;
+
+    // Forward-only bulk evaluation writes the forward-only buffer only
+    backend.evaluate(numPaths, inputsSoA, outputsSoA);
+    backend.forward(forwardOutputs);
+    backend.forwardAndBackward(outputs, gradients);
+    // Final batch: paths from lastBatch on, unused lanes repeat the last path
+    const std::size_t lastBatch = (numPaths - 1) / BATCH_SIZE * BATCH_SIZE;
+    for (int lane = 0; lane < BATCH_SIZE; ++lane)
+    {
+        EXPECT_EQ(forwardOutputs[lane], outputs[lane]) << "lane " << lane;
+        const std::size_t path = std::min<std::size_t>(lastBatch + lane, numPaths - 1);
+        EXPECT_NEAR(inputsSoA[path] * inputsSoA[numPaths + path] + inputsSoA[path] * inputsSoA[path], outputs[lane],
+                    1e-12)
+            << "lane " << lane;
+    }
+}
+
+// =============================================================================
+// Forward-only evaluation (no adjoint sweep)
+// =============================================================================
+
+TYPED_TEST(AVXBackendTest, ForwardOnlyBatched)
+{
+    constexpr int BATCH_SIZE = TypeParam::VECTOR_WIDTH;
+    std::vector<double> inputs = {1.0, 2.0, 3.0, 4.0, 0.5, 1.5, 2.5, 3.5};
+
+    std::vector<double> refOutputs, refDerivatives;
+    this->computeReference(f3<xad::AD>, inputs, refOutputs, refDerivatives);
+
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(inputs[0]);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD y = f3(x);
+    jit.registerOutput(y);
+
+    TypeParam avx;
+    avx.compile(jit.getGraph());
+
+    for (std::size_t batch = 0; batch < inputs.size(); batch += BATCH_SIZE)
+    {
+        double inputBatch[BATCH_SIZE];
+        for (int i = 0; i < BATCH_SIZE; ++i)
+            inputBatch[i] = inputs[batch + i];
+        avx.setInput(0, inputBatch);
+
+        double outputs[BATCH_SIZE];
+        avx.forward(outputs);
+
+        for (int i = 0; i < BATCH_SIZE; ++i)
+        {
+            std::size_t idx = batch + i;
+            EXPECT_NEAR(refOutputs[idx], outputs[i], 1e-10)
+                << "Forward-only mismatch at index " << idx;
+        }
+
+        // The forward+backward kernel must see the same inputs
+        double inputGradients[BATCH_SIZE];
+        avx.forwardAndBackward(outputs, inputGradients);
+
+        for (int i = 0; i < BATCH_SIZE; ++i)
+        {
+            std::size_t idx = batch + i;
+            EXPECT_NEAR(refOutputs[idx], outputs[i], 1e-10)
+                << "Output mismatch at index " << idx;
+            EXPECT_NEAR(refDerivatives[idx], inputGradients[i], 1e-10)
+                << "Gradient mismatch at index " << idx;
+        }
+    }
+}
+
+// =============================================================================
+// Bulk evaluation over many paths (with partial final batch)
+// =============================================================================
+
+TYPED_TEST(AVXBackendTest, BulkEvaluateWithTail)
+{
+    // 11 paths: the final batch is partial for both 4 and 8 lanes
+    const std::size_t numPaths = 11;
+
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0), y(2.0);
+    jit.registerInput(x);
+    jit.registerInput(y);
+    jit.newRecording();
+    xad::AD z = x * y + x * x;
+    jit.registerOutput(z);
+
+    TypeParam avx;
+    avx.compile(jit.getGraph());
+
+    // SoA layout: all x values, then all y values
+    std::vector<double> inputs(2 * numPaths);
+    for (std::size_t p = 0; p < numPaths; ++p)
+    {
+        inputs[p] = 0.25 * static_cast<double>(p) - 1.0;
+        inputs[numPaths + p] = 2.0 - 0.5 * static_cast<double>(p);
+    }
+
+    std::vector<double> outputs(numPaths, 0.0);
+    std::vector<double> gradients(2 * numPaths, 0.0);
+    avx.evaluate(numPaths, inputs.data(), outputs.data(), gradients.data());
+
+    std::vector<double> forwardOnly(numPaths, 0.0);
+    avx.evaluate(numPaths, inputs.data(), forwardOnly.data());
+
+    for (std::size_t p = 0; p < numPaths; ++p)
+    {
+        double xval = inputs[p];
+        double yval = inputs[numPaths + p];
+        EXPECT_NEAR(xval * yval + xval * xval, outputs[p], 1e-10)
+            << "Output mismatch at path " << p;
+        EXPECT_NEAR(outputs[p], forwardOnly[p], 1e-10)
+            << "Forward-only mismatch at path " << p;
+        EXPECT_NEAR(yval + 2.0 * xval, gradients[p], 1e-10)
+            << "dx mismatch at path " << p;
+        EXPECT_NEAR(xval, gradients[numPaths + p], 1e-10)
+            << "dy mismatch at path " << p;
+    }
+}
+
+TYPED_TEST(AVXBackendTest, OutputAdjointsWeightGradients)
+{
+    constexpr int BATCH_SIZE = TypeParam::VECTOR_WIDTH;
+    // Two outputs: f1 = x*y, f2 = x + y*y
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0), y(2.0);
+    jit.registerInput(x);
+    jit.registerInput(y);
+    jit.newRecording();
+    xad::AD f1 = x * y;
+    xad::AD f2 = x + y * y;
+    jit.registerOutput(f1);
+    jit.registerOutput(f2);
+
+    TypeParam avx;
+    avx.compile(jit.getGraph());
+
+    double values[2 * BATCH_SIZE];
+    for (int i = 0; i < BATCH_SIZE; ++i)
+    {
+        values[i] = 0.75 * i - 0.5;
+        values[BATCH_SIZE + i] = 2.0 - 0.5 * i;
+    }
+    avx.setInputs(values);
+
+    // Per-lane weights of f1 and f2
+    double adjoints[2 * BATCH_SIZE];
+    for (int lane = 0; lane < BATCH_SIZE; ++lane)
+    {
+        adjoints[lane] = 1.0 - 0.5 * lane;
+        adjoints[BATCH_SIZE + lane] = 0.5 * (lane % 3);
+    }
+    double outputs[2 * BATCH_SIZE], gradients[2 * BATCH_SIZE];
+    avx.forwardAndBackward(outputs, adjoints, gradients);
+
+    for (int lane = 0; lane < BATCH_SIZE; ++lane)
+    {
+        const double xv = values[lane], yv = values[BATCH_SIZE + lane];
+        const double w1 = adjoints[lane], w2 = adjoints[BATCH_SIZE + lane];
+        EXPECT_NEAR(xv * yv, outputs[lane], 1e-12) << "f1 mismatch at lane " << lane;
+        EXPECT_NEAR(xv + yv * yv, outputs[BATCH_SIZE + lane], 1e-12) << "f2 mismatch at lane " << lane;
+        EXPECT_NEAR(w1 * yv + w2, gradients[lane], 1e-12) << "dx mismatch at lane " << lane;
+        EXPECT_NEAR(w1 * xv + w2 * 2.0 * yv, gradients[BATCH_SIZE + lane], 1e-12) << "dy mismatch at lane " << lane;
+    }
+
+    // Inputs set after the VJP kernel exists reach it as well
+    double next[2 * BATCH_SIZE];
+    for (int i = 0; i < 2 * BATCH_SIZE; ++i)
+        next[i] = i < BATCH_SIZE ? 0.5 : 1.0;
+    avx.setInputs(next);
+    avx.forwardAndBackward(outputs, adjoints, gradients);
+    EXPECT_NEAR(0.5 * adjoints[0] + 2.0 * adjoints[BATCH_SIZE], gradients[BATCH_SIZE], 1e-12);
+    EXPECT_GT(avx.kernel()->compileStats().vjpCompileMs, 0.0);
+}
+
+TYPED_TEST(AVXBackendTest, OutputAdjointScalesSingleOutput)
+{
+    constexpr int BATCH_SIZE = TypeParam::VECTOR_WIDTH;
+    // f = x*y + x^2
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0), y(2.0);
+    jit.registerInput(x);
+    jit.registerInput(y);
+    jit.newRecording();
+    xad::AD z = x * y + x * x;
+    jit.registerOutput(z);
+
+    TypeParam avx;
+    avx.compile(jit.getGraph());
+    double values[2 * BATCH_SIZE];
+    for (int i = 0; i < BATCH_SIZE; ++i)
+    {
+        values[i] = 0.75 * i - 0.5;
+        values[BATCH_SIZE + i] = 2.0 - 0.5 * i;
+    }
+    avx.setInputs(values);
+
+    double adjoints[BATCH_SIZE];
+    for (int lane = 0; lane < BATCH_SIZE; ++lane)
+        adjoints[lane] = 2.0 - 1.25 * lane;
+    double outputs[BATCH_SIZE], gradients[2 * BATCH_SIZE];
+    avx.forwardAndBackward(outputs, adjoints, gradients);
+    for (int lane = 0; lane < BATCH_SIZE; ++lane)
+    {
+        const double xv = values[lane], yv = values[BATCH_SIZE + lane];
+        EXPECT_NEAR(adjoints[lane] * (yv + 2.0 * xv), gradients[lane], 1e-12);
+        EXPECT_NEAR(adjoints[lane] * xv, gradients[BATCH_SIZE + lane], 1e-12);
+    }
+}
+
+// =============================================================================
+// Gradient accumulation test
+// =============================================================================
+
+TYPED_TEST(AVXBackendTest, AccumulateMatchesSummedEvaluate)
+{
+    // 11 paths: the unused lanes of the final batch must not be accumulated
+    const std::size_t numPaths = 11;
+
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0), y(2.0);
+    jit.registerInput(x);
+    jit.registerInput(y);
+    jit.newRecording();
+    xad::AD z = x * y + x * x;
+    jit.registerOutput(z);
+
+    TypeParam avx;
+    avx.compile(jit.getGraph());
+
+    std::vector<double> inputs(2 * numPaths);
+    for (std::size_t p = 0; p < numPaths; ++p)
+    {
+        inputs[p] = 0.25 * static_cast<double>(p) - 1.0;
+        inputs[numPaths + p] = 2.0 - 0.5 * static_cast<double>(p);
+    }
+
+    std::vector<double> outputs(numPaths, 0.0);
+    std::vector<double> gradients(2 * numPaths, 0.0);
+    avx.evaluate(numPaths, inputs.data(), outputs.data(), gradients.data());
+
+    double expectedValue = 0.0, expectedDx = 0.0, expectedDy = 0.0;
+    for (std::size_t p = 0; p < numPaths; ++p)
+    {
+        expectedValue += outputs[p];
+        expectedDx += gradients[p];
+        expectedDy += gradients[numPaths + p];
+    }
+
+    // Accumulate twice to check that clearAccumulators() resets the sums
+    for (int run = 0; run < 2; ++run)
+    {
+        avx.clearAccumulators();
+        avx.accumulate(numPaths, inputs.data());
+        EXPECT_EQ(numPaths, avx.accumulatedPaths());
+
+        double value = 0.0;
+        double grads[2] = {0.0, 0.0};
+        avx.getAccumulatedOutputs(&value);
+        avx.getAccumulatedGradients(grads);
+
+        EXPECT_NEAR(expectedValue, value, 1e-10);
+        EXPECT_NEAR(expectedDx, grads[0], 1e-10);
+        EXPECT_NEAR(expectedDy, grads[1], 1e-10);
+    }
+}
+
 // =============================================================================
 // Reset and recompile test
 // =============================================================================
 
-TEST_F(AVXBackendTest, ResetAndRecompile)
+TYPED_TEST(AVXBackendTest, ResetAndRecompile)
 {
-    xad::forge::ForgeBackendAVX<double> avx;
+    constexpr int BATCH_SIZE = TypeParam::VECTOR_WIDTH;
+    TypeParam avx;
 
     // First function: f(x) = 2x
     {
@@ -434,7 +854,9 @@ TEST_F(AVXBackendTest, ResetAndRecompile)
 
         avx.compile(jit.getGraph());
 
-        double inputBatch[BATCH_SIZE] = {1.0, 2.0, 3.0, 4.0};
+        double inputBatch[BATCH_SIZE];
+        for (int i = 0; i < BATCH_SIZE; ++i)
+            inputBatch[i] = 1.0 + i;
         avx.setInput(0, inputBatch);
 
         double outputs[BATCH_SIZE];
@@ -462,7 +884,9 @@ TEST_F(AVXBackendTest, ResetAndRecompile)
 
         avx.compile(jit.getGraph());
 
-        double inputBatch[BATCH_SIZE] = {1.0, 2.0, 3.0, 4.0};
+        double inputBatch[BATCH_SIZE];
+        for (int i = 0; i < BATCH_SIZE; ++i)
+            inputBatch[i] = 1.0 + i;
         avx.setInput(0, inputBatch);
 
         double outputs[BATCH_SIZE];
@@ -0,0 +1,272 @@
+/*
+ * xad-forge Graph Optimizer Test Suite
+ *
+ * Tests the GraphOptimizer pre-pass on recorded JITGraphs:
+ * - Nodes that reach no output are removed
+ * - Repeated subexpressions are merged
+ * - Constant-only nodes are folded
+ * - Optimized graphs give the same values and gradients as the originals
+ *
+ * Copyright (c) 2025 The xad-forge Authors
+ * https://github.com/da-roth/xad-forge
+ * SPDX-License-Identifier: Zlib
+ */
+
+#include <xad-forge/ForgeBackend.hpp>
+#include <xad-forge/GraphOptimizer.hpp>
+#include <XAD/XAD.hpp>
+#include <XAD/JITGraphInterpreter.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include <memory>
+
+namespace {
+
+// Evaluates a single-input, single-output graph with and without the
+// prepass and checks that values and derivatives agree
+void expectSameResults(const xad::JITGraph& graph, const std::vector<double>& xs)
+{
+    xad::forge::ForgeBackend<double> plain, optimized;
+    optimized.setPrepass(true);
+    plain.compile(graph);
+    optimized.compile(graph);
+
+    for (double x : xs)
+    {
+        double out1 = 0.0, out2 = 0.0, grad1 = 0.0, grad2 = 0.0;
+        plain.setInput(0, &x);
+        optimized.setInput(0, &x);
+        plain.forwardAndBackward(&out1, &grad1);
+        optimized.forwardAndBackward(&out2, &grad2);
+        EXPECT_NEAR(out1, out2, 1e-12) << "x = " << x;
+        EXPECT_NEAR(grad1, grad2, 1e-12) << "x = " << x;
+    }
+}
+
+} // anonymous namespace
+
+TEST(GraphOptimizerTest, RemovesDeadNodes)
+{
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD unused = sin(x) * exp(x);
+    xad::AD y = x * 3.0 + 2.0;
+    jit.registerOutput(y);
+    (void)unused;
+
+    xad::forge::GraphOptimizationStats stats;
+    xad::JITGraph optimized = xad::forge::GraphOptimizer::optimize(jit.getGraph(),
+                                                                   xad::forge::GraphOptimizationOptions(), &stats);
+
+    EXPECT_EQ(jit.getGraph().nodeCount(), stats.nodesBefore);
+    EXPECT_EQ(optimized.nodeCount(), stats.nodesAfter);
+    EXPECT_GE(stats.deadNodesRemoved, 3u);
+    EXPECT_EQ(stats.nodesBefore - stats.nodesAfter, stats.deadNodesRemoved + stats.duplicatesMerged);
+    EXPECT_EQ(jit.getGraph().input_ids.size(), optimized.input_ids.size());
+    EXPECT_EQ(jit.getGraph().output_ids.size(), optimized.output_ids.size());
+
+    expectSameResults(jit.getGraph(), {-1.0, 0.5, 2.0});
+}
+
+TEST(GraphOptimizerTest, MergesCommonSubexpressions)
+{
+    // Discount factor exp(-r t) recomputed for every cash flow
+    xad::JITCompiler<double, 1> jit;
+    xad::AD r(0.03);
+    jit.registerInput(r);
+    jit.newRecording();
+    xad::AD pv = 0.0;
+    for (int i = 0; i < 4; ++i)
+    {
+        xad::AD df = exp(-r * 5.0);
+        pv = pv + 100.0 * df;
+    }
+    jit.registerOutput(pv);
+
+    xad::forge::GraphOptimizationStats stats;
+    xad::forge::GraphOptimizer::optimize(jit.getGraph(), xad::forge::GraphOptimizationOptions(), &stats);
+
+    // Three of the four discount factors (and the products feeding them) are duplicates
+    EXPECT_GE(stats.duplicatesMerged, 3u);
+    EXPECT_LT(stats.nodesAfter, stats.nodesBefore);
+
+    expectSameResults(jit.getGraph(), {0.0, 0.03, 0.1});
+}
+
+TEST(GraphOptimizerTest, FoldsConstantOnlyNodes)
+{
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD y = x * x;
+    jit.registerOutput(y);
+
+    // Append c = 3, k = op(c, c) and z = op(y, k), where op is the operation
+    // that computed y; k depends on constants only
+    xad::JITGraph graph = jit.getGraph();
+    const uint32_t yIndex = graph.output_ids[0];
+    auto square = graph.nodes[yIndex];
+
+    auto constant = square;
+    constant.op = static_cast<decltype(constant.op)>(FORGE_OP_CONSTANT);
+    constant.a = constant.b = constant.c = 0;
+    constant.imm = static_cast<double>(graph.const_pool.size());
+    constant.flags = 0;
+    graph.const_pool.push_back(3.0);
+    const uint32_t cIndex = static_cast<uint32_t>(graph.nodes.size());
+    graph.nodes.push_back(constant);
+
+    auto k = square;
+    k.a = k.b = cIndex;
+    k.flags = 0;
+    const uint32_t kIndex = static_cast<uint32_t>(graph.nodes.size());
+    graph.nodes.push_back(k);
+
+    auto z = square;
+    z.a = yIndex;
+    z.b = kIndex;
+    graph.output_ids[0] = static_cast<uint32_t>(graph.nodes.size());
+    graph.nodes.push_back(z);
+
+    xad::forge::GraphOptimizationStats stats;
+    xad::JITGraph optimized =
+        xad::forge::GraphOptimizer::optimize(graph, xad::forge::GraphOptimizationOptions(), &stats);
+    EXPECT_EQ(1u, stats.constantsFolded);
+
+    // The folded graph matches the interpreter on the original graph
+    xad::JITGraphInterpreter<double> interpreter;
+    interpreter.compile(graph);
+    xad::forge::ForgeBackend<double> backend;
+    backend.compile(optimized);
+    for (double xv : {-2.0, 0.5, 1.5})
+    {
+        double expected = 0.0, actual = 0.0;
+        interpreter.setInput(0, &xv);
+        interpreter.forward(&expected);
+        backend.setInput(0, &xv);
+        backend.forward(&actual);
+        EXPECT_NEAR(expected, actual, 1e-12) << "x = " << xv;
+    }
+
+    // A runtime constant is not folded
+    xad::forge::GraphOptimizationOptions options;
+    options.runtimeConstants.push_back(static_cast<std::size_t>(constant.imm));
+    xad::forge::GraphOptimizer::optimize(graph, options, &stats);
+    EXPECT_EQ(0u, stats.constantsFolded);
+}
+
+TEST(GraphOptimizerTest, FoldsUnaryOpWhenNodeZeroIsInput)
+{
+    // A unary op leaves its unused operand fields 0; with the input at node 0
+    // they must not make a constant-only unary node depend on the input
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD e = exp(x);
+    xad::AD y = e * x;
+    jit.registerOutput(y);
+
+    // Append c = 0.5, k = exp(c) and z = k * y, reusing the recorded exp and
+    // product nodes
+    xad::JITGraph graph = jit.getGraph();
+    ASSERT_EQ(0u, graph.input_ids[0]);
+    const uint32_t yIndex = graph.output_ids[0];
+    auto product = graph.nodes[yIndex];
+    auto unary = graph.nodes[product.a == graph.input_ids[0] ? product.b : product.a];
+
+    auto constant = unary;
+    constant.op = static_cast<decltype(constant.op)>(FORGE_OP_CONSTANT);
+    constant.a = constant.b = constant.c = 0;
+    constant.imm = static_cast<double>(graph.const_pool.size());
+    constant.flags = 0;
+    graph.const_pool.push_back(0.5);
+    const uint32_t cIndex = static_cast<uint32_t>(graph.nodes.size());
+    graph.nodes.push_back(constant);
+
+    auto k = unary;
+    k.a = cIndex;
+    k.flags = 0;
+    const uint32_t kIndex = static_cast<uint32_t>(graph.nodes.size());
+    graph.nodes.push_back(k);
+
+    auto z = product;
+    z.a = kIndex;
+    z.b = yIndex;
+    graph.output_ids[0] = static_cast<uint32_t>(graph.nodes.size());
+    graph.nodes.push_back(z);
+
+    xad::forge::GraphOptimizationStats stats;
+    xad::JITGraph optimized =
+        xad::forge::GraphOptimizer::optimize(graph, xad::forge::GraphOptimizationOptions(), &stats);
+    EXPECT_EQ(1u, stats.constantsFolded);
+
+    xad::JITGraphInterpreter<double> interpreter;
+    interpreter.compile(graph);
+    xad::forge::ForgeBackend<double> backend;
+    backend.compile(optimized);
+    for (double xv : {-1.0, 0.25, 2.0})
+    {
+        double expected = 0.0, actual = 0.0;
+        interpreter.setInput(0, &xv);
+        interpreter.forward(&expected);
+        backend.setInput(0, &xv);
+        backend.forward(&actual);
+        EXPECT_NEAR(expected, actual, 1e-12) << "x = " << xv;
+    }
+}
+
+TEST(GraphOptimizerTest, PassesCanBeDisabled)
+{
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD unused = cos(x);
+    xad::AD y = sin(x) + sin(x);
+    jit.registerOutput(y);
+    (void)unused;
+
+    xad::forge::GraphOptimizationOptions options;
+    options.eliminateDeadCode = false;
+    options.eliminateCommonSubexpressions = false;
+    options.foldConstants = false;
+
+    xad::forge::GraphOptimizationStats stats;
+    xad::JITGraph same = xad::forge::GraphOptimizer::optimize(jit.getGraph(), options, &stats);
+    EXPECT_EQ(jit.getGraph().nodeCount(), same.nodeCount());
+    EXPECT_EQ(0u, stats.deadNodesRemoved);
+    EXPECT_EQ(0u, stats.duplicatesMerged);
+}
+
+TEST(GraphOptimizerTest, BackendPrepassReportsStats)
+{
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD y = exp(x) * exp(x);
+    jit.registerOutput(y);
+
+    xad::forge::ForgeBackend<double> backend;
+    backend.setPrepass(true);
+    backend.compile(jit.getGraph());
+    EXPECT_EQ(jit.getGraph().nodeCount(), backend.prepassStats().nodesBefore);
+    EXPECT_GE(backend.prepassStats().duplicatesMerged, 1u);
+
+    double xv = 0.7, output = 0.0, gradient = 0.0;
+    backend.setInput(0, &xv);
+    backend.forwardAndBackward(&output, &gradient);
+    EXPECT_NEAR(std::exp(2.0 * xv), output, 1e-12);
+    EXPECT_NEAR(2.0 * std::exp(2.0 * xv), gradient, 1e-12);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
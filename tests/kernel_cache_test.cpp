@@ -0,0 +1,222 @@
+/*
+ * xad-forge Kernel Cache Test Suite
+ *
+ * Tests the keys used to cache compiled kernels:
+ * - Identical recordings hash equally, across separate JITCompiler instances
+ * - Any change to structure, constants, instruction set or options changes
+ *   the hash
+ *
+ * Tests the in-process KernelCache:
+ * - Backends compiling identical graphs share one kernel
+ * - Least recently used kernels are evicted beyond the byte budget
+ * - Graphs differing only in runtime constants share one kernel, and
+ *   backends attached to it run with the constants they load
+ *
+ * Copyright (c) 2025 The xad-forge Authors
+ * https://github.com/da-roth/xad-forge
+ * SPDX-License-Identifier: Zlib
+ */
+
+#include <xad-forge/ForgeBackend.hpp>
+#include <xad-forge/GraphHash.hpp>
+#include <xad-forge/KernelCache.hpp>
+#include <XAD/XAD.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include <memory>
+
+namespace {
+
+// Records f(x) = x * scale + 2 and returns the hash of the graph
+xad::forge::GraphHash hashOf(double scale, ForgeInstructionSet isa = FORGE_INSTRUCTION_SET_SSE2_SCALAR,
+                             bool useGraphOptimizations = false)
+{
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD y = x * scale + 2.0;
+    jit.registerOutput(y);
+    return xad::forge::GraphHash::compute(jit.getGraph(), isa, useGraphOptimizations);
+}
+
+// Records f(x) = x * scale + 2 into jit
+void record(xad::JITCompiler<double, 1>& jit, double scale)
+{
+    xad::AD x(1.0);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD y = x * scale + 2.0;
+    jit.registerOutput(y);
+}
+
+// Index of value in the graph's constant pool
+std::size_t constIndexOf(const xad::JITGraph& graph, double value)
+{
+    for (std::size_t i = 0; i < graph.const_pool.size(); ++i)
+        if (graph.const_pool[i] == value)
+            return i;
+    return graph.const_pool.size();
+}
+
+} // anonymous namespace
+
+TEST(GraphHashTest, IdenticalRecordingsHashEqually)
+{
+    xad::forge::GraphHash a = hashOf(3.0);
+    xad::forge::GraphHash b = hashOf(3.0);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a.toString(), b.toString());
+    EXPECT_EQ(32u, a.toString().size());
+}
+
+TEST(GraphHashTest, ConstantsInstructionSetAndOptionsChangeHash)
+{
+    xad::forge::GraphHash base = hashOf(3.0);
+    EXPECT_NE(base, hashOf(4.0));
+    EXPECT_NE(base, hashOf(3.0, FORGE_INSTRUCTION_SET_AVX2_PACKED));
+    EXPECT_NE(base, hashOf(3.0, FORGE_INSTRUCTION_SET_SSE2_SCALAR, true));
+}
+
+TEST(GraphHashTest, StructureChangesHash)
+{
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD y = x * x + 2.0;
+    jit.registerOutput(y);
+
+    EXPECT_NE(hashOf(3.0),
+              xad::forge::GraphHash::compute(jit.getGraph(), FORGE_INSTRUCTION_SET_SSE2_SCALAR, false));
+}
+
+TEST(KernelCacheTest, IdenticalGraphsShareKernel)
+{
+    xad::forge::KernelCache cache;
+
+    xad::JITCompiler<double, 1> jit1, jit2, jit3;
+    record(jit1, 3.0);
+    record(jit2, 3.0);
+    record(jit3, 5.0);
+
+    xad::forge::ForgeBackend<double> b1, b2, b3;
+    b1.setKernelCache(&cache);
+    b2.setKernelCache(&cache);
+    b3.setKernelCache(&cache);
+    b1.compile(jit1.getGraph());
+    b2.compile(jit2.getGraph());
+    b3.compile(jit3.getGraph());
+
+    EXPECT_EQ(b1.kernel(), b2.kernel());
+    EXPECT_NE(b1.kernel(), b3.kernel());
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_EQ(1u, cache.hits());
+    EXPECT_EQ(2u, cache.misses());
+
+    // Shared kernel, separate buffers: each backend evaluates independently
+    double x1 = 2.0, x3 = 2.0, out1 = 0.0, out3 = 0.0, grad1 = 0.0, grad3 = 0.0;
+    b1.setInput(0, &x1);
+    b3.setInput(0, &x3);
+    b1.forwardAndBackward(&out1, &grad1);
+    b3.forwardAndBackward(&out3, &grad3);
+    EXPECT_NEAR(8.0, out1, 1e-10);
+    EXPECT_NEAR(3.0, grad1, 1e-10);
+    EXPECT_NEAR(12.0, out3, 1e-10);
+    EXPECT_NEAR(5.0, grad3, 1e-10);
+}
+
+TEST(KernelCacheTest, EvictsLeastRecentlyUsed)
+{
+    xad::JITCompiler<double, 1> jitA, jitB, jitC;
+    record(jitA, 1.0);
+    record(jitB, 2.0);
+    record(jitC, 3.0);
+
+    // Budget for exactly two entries of this size (kernel plus graph copy)
+    xad::forge::KernelCache probe;
+    probe.getOrCompile(jitA.getGraph(), FORGE_INSTRUCTION_SET_SSE2_SCALAR);
+    const std::size_t entryBytes = probe.bytesUsed();
+    EXPECT_GT(entryBytes,
+              xad::forge::ForgeKernel::compile(jitA.getGraph(), FORGE_INSTRUCTION_SET_SSE2_SCALAR)->estimatedBytes());
+    xad::forge::KernelCache cache(2 * entryBytes);
+
+    std::shared_ptr<const xad::forge::ForgeKernel> a =
+        cache.getOrCompile(jitA.getGraph(), FORGE_INSTRUCTION_SET_SSE2_SCALAR);
+    cache.getOrCompile(jitB.getGraph(), FORGE_INSTRUCTION_SET_SSE2_SCALAR);
+
+    // Touch A so that B becomes least recently used, then insert C
+    EXPECT_EQ(a, cache.getOrCompile(jitA.getGraph(), FORGE_INSTRUCTION_SET_SSE2_SCALAR));
+    cache.getOrCompile(jitC.getGraph(), FORGE_INSTRUCTION_SET_SSE2_SCALAR);
+
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_LE(cache.bytesUsed(), cache.byteBudget());
+    EXPECT_EQ(a, cache.getOrCompile(jitA.getGraph(), FORGE_INSTRUCTION_SET_SSE2_SCALAR));
+
+    const std::size_t missesBefore = cache.misses();
+    cache.getOrCompile(jitB.getGraph(), FORGE_INSTRUCTION_SET_SSE2_SCALAR);
+    EXPECT_EQ(missesBefore + 1, cache.misses()) << "B should have been evicted";
+
+    // Shrinking the budget evicts immediately
+    cache.setByteBudget(0);
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ(0u, cache.bytesUsed());
+}
+
+TEST(KernelCacheTest, RuntimeConstantsShareKernel)
+{
+    xad::forge::KernelCache cache;
+
+    xad::JITCompiler<double, 1> jit3, jit5;
+    record(jit3, 3.0);
+    record(jit5, 5.0);
+    const std::size_t scaleIndex = constIndexOf(jit3.getGraph(), 3.0);
+    ASSERT_LT(scaleIndex, jit3.getGraph().const_pool.size());
+    ASSERT_EQ(scaleIndex, constIndexOf(jit5.getGraph(), 5.0));
+
+    std::vector<std::size_t> runtimeConstants(1, scaleIndex);
+    EXPECT_EQ(xad::forge::GraphHash::compute(jit3.getGraph(), FORGE_INSTRUCTION_SET_SSE2_SCALAR, false,
+                                             runtimeConstants),
+              xad::forge::GraphHash::compute(jit5.getGraph(), FORGE_INSTRUCTION_SET_SSE2_SCALAR, false,
+                                             runtimeConstants));
+
+    xad::forge::ForgeBackend<double> b3, b5;
+    b3.setKernelCache(&cache);
+    b5.setKernelCache(&cache);
+    b3.setRuntimeConstants(runtimeConstants);
+    b5.setRuntimeConstants(runtimeConstants);
+    b3.compile(jit3.getGraph());
+    b5.compile(jit5.getGraph());
+
+    EXPECT_EQ(b3.kernel(), b5.kernel());
+    EXPECT_EQ(1u, cache.size());
+
+    // Each backend runs with the constants of the graph it compiled
+    double x = 2.0, out3 = 0.0, out5 = 0.0, grad3 = 0.0, grad5 = 0.0;
+    b3.setInput(0, &x);
+    b5.setInput(0, &x);
+    b3.forwardAndBackward(&out3, &grad3);
+    b5.forwardAndBackward(&out5, &grad5);
+    EXPECT_NEAR(8.0, out3, 1e-10);
+    EXPECT_NEAR(3.0, grad3, 1e-10);
+    EXPECT_NEAR(12.0, out5, 1e-10);
+    EXPECT_NEAR(5.0, grad5, 1e-10);
+
+    // Attaching to the cached kernel gives the constants of the graph that
+    // compiled it first, until the caller's graph is loaded
+    xad::forge::ForgeBackend<double> attached(b5.kernel());
+    attached.setInput(0, &x);
+    attached.forwardAndBackward(&out5, &grad5);
+    EXPECT_NEAR(8.0, out5, 1e-10);
+    attached.loadConstants(jit5.getGraph());
+    attached.forwardAndBackward(&out5, &grad5);
+    EXPECT_NEAR(12.0, out5, 1e-10);
+    EXPECT_NEAR(5.0, grad5, 1e-10);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,244 @@
+/*
+ * xad-forge ParallelExecutor Test Suite
+ *
+ * Tests multi-threaded execution of a shared compiled kernel:
+ * - Per-path outputs and gradients match single-threaded evaluation
+ * - Reduced sums match per-path results and do not depend on thread count
+ * - Path counts that are not a multiple of the chunk size
+ * - Worker threads are reused across runs, including after a failed run
+ * - Executors built directly from ForgeKernel::compile()
+ * - Runtime constants changed on the backend or executor reach every worker
+ *
+ * Copyright (c) 2025 The xad-forge Authors
+ * https://github.com/da-roth/xad-forge
+ * SPDX-License-Identifier: Zlib
+ */
+
+#include <xad-forge/ForgeBackend.hpp>
+#include <xad-forge/ParallelExecutor.hpp>
+#include <XAD/XAD.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include <memory>
+
+namespace {
+
+// f(x, y) = x*y + x^2, df/dx = y + 2x, df/dy = x
+double pathX(std::size_t path)
+{
+    return static_cast<double>(path % 97) / 10.0 - 4.0;
+}
+
+double pathY(std::size_t path)
+{
+    return static_cast<double>(path % 13) / 4.0 + 0.5;
+}
+
+void generateInputs(std::size_t path, double* inputs)
+{
+    inputs[0] = pathX(path);
+    inputs[1] = pathY(path);
+}
+
+} // anonymous namespace
+
+class ParallelExecutorTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        xad::AD x(1.0), y(2.0);
+        jit.registerInput(x);
+        jit.registerInput(y);
+        jit.newRecording();
+        xad::AD z = x * y + x * x;
+        jit.registerOutput(z);
+
+        backend.compile(jit.getGraph());
+    }
+
+    xad::JITCompiler<double, 1> jit;
+    xad::forge::ForgeBackend<double> backend;
+};
+
+TEST_F(ParallelExecutorTest, PerPathResults)
+{
+    // Not a multiple of the chunk size, so the last chunk is partial
+    const std::size_t numPaths = 1001;
+
+    xad::forge::ParallelExecutor exec(backend, 4, 64);
+    ASSERT_EQ(4u, exec.numThreads());
+
+    std::vector<double> outputs(numPaths, 0.0);
+    std::vector<double> gradients(2 * numPaths, 0.0);
+    exec.run(numPaths, generateInputs, outputs.data(), gradients.data());
+
+    for (std::size_t p = 0; p < numPaths; ++p)
+    {
+        double x = pathX(p), y = pathY(p);
+        EXPECT_NEAR(x * y + x * x, outputs[p], 1e-10) << "Output mismatch at path " << p;
+        EXPECT_NEAR(y + 2.0 * x, gradients[p], 1e-10) << "dx mismatch at path " << p;
+        EXPECT_NEAR(x, gradients[numPaths + p], 1e-10) << "dy mismatch at path " << p;
+    }
+
+    // Forward-only run
+    std::vector<double> forwardOnly(numPaths, 0.0);
+    exec.run(numPaths, generateInputs, forwardOnly.data());
+    for (std::size_t p = 0; p < numPaths; ++p)
+        EXPECT_NEAR(outputs[p], forwardOnly[p], 1e-10) << "Forward-only mismatch at path " << p;
+}
+
+TEST_F(ParallelExecutorTest, ReducedSumsIndependentOfThreadCount)
+{
+    const std::size_t numPaths = 5000;
+
+    double refOutput = 0.0, refDx = 0.0, refDy = 0.0;
+    for (std::size_t p = 0; p < numPaths; ++p)
+    {
+        double x = pathX(p), y = pathY(p);
+        refOutput += x * y + x * x;
+        refDx += y + 2.0 * x;
+        refDy += x;
+    }
+
+    xad::forge::ParallelExecutor single(backend.kernel(), 1, 128);
+    xad::forge::ParallelExecutor::Result a = single.runReduced(numPaths, generateInputs);
+
+    xad::forge::ParallelExecutor multi(backend.kernel(), 8, 128);
+    xad::forge::ParallelExecutor::Result b = multi.runReduced(numPaths, generateInputs);
+
+    ASSERT_EQ(1u, a.outputSums.size());
+    ASSERT_EQ(2u, a.gradientSums.size());
+    EXPECT_EQ(numPaths, a.numPaths);
+
+    EXPECT_NEAR(refOutput, a.outputSums[0], 1e-6);
+    EXPECT_NEAR(refDx, a.gradientSums[0], 1e-6);
+    EXPECT_NEAR(refDy, a.gradientSums[1], 1e-6);
+
+    // Chunk-ordered reduction gives bitwise identical sums
+    EXPECT_EQ(a.outputSums[0], b.outputSums[0]);
+    EXPECT_EQ(a.gradientSums[0], b.gradientSums[0]);
+    EXPECT_EQ(a.gradientSums[1], b.gradientSums[1]);
+
+    // Without gradients only outputs are reduced
+    xad::forge::ParallelExecutor::Result c = multi.runReduced(numPaths, generateInputs, false);
+    EXPECT_TRUE(c.gradientSums.empty());
+    EXPECT_NEAR(a.outputSums[0], c.outputSums[0], 1e-9);
+}
+
+TEST_F(ParallelExecutorTest, FromCompiledKernel)
+{
+    // compile() returns a non-const kernel pointer, which must select the
+    // kernel constructor rather than the backend one
+    std::shared_ptr<xad::forge::ForgeKernel> kernel =
+        xad::forge::ForgeKernel::compile(jit.getGraph(), FORGE_INSTRUCTION_SET_SSE2_SCALAR);
+    xad::forge::ParallelExecutor exec(kernel, 2, 16);
+    xad::forge::ParallelExecutor exec2(xad::forge::ForgeKernel::compile(jit.getGraph(),
+                                                                        FORGE_INSTRUCTION_SET_SSE2_SCALAR));
+
+    xad::forge::ParallelExecutor ref(backend, 2, 16);
+    xad::forge::ParallelExecutor::Result expected = ref.runReduced(500, generateInputs);
+    xad::forge::ParallelExecutor::Result a = exec.runReduced(500, generateInputs);
+    xad::forge::ParallelExecutor::Result b = exec2.runReduced(500, generateInputs);
+    EXPECT_EQ(expected.outputSums[0], a.outputSums[0]);
+    EXPECT_EQ(expected.gradientSums[0], a.gradientSums[0]);
+    EXPECT_EQ(expected.gradientSums[1], a.gradientSums[1]);
+    EXPECT_NEAR(expected.outputSums[0], b.outputSums[0], 1e-9);
+    EXPECT_NEAR(expected.gradientSums[1], b.gradientSums[1], 1e-9);
+}
+
+TEST_F(ParallelExecutorTest, WorkersPersistAcrossRuns)
+{
+    xad::forge::ParallelExecutor exec(backend, 4, 16);
+    xad::forge::ParallelExecutor::Result ref = exec.runReduced(1000, generateInputs);
+
+    // Runs using fewer workers than the pool holds, and a failing run,
+    // leave the pool ready for the next run
+    for (int run = 0; run < 20; ++run)
+    {
+        const std::size_t numPaths = run % 2 == 0 ? 1000 : 10;
+        xad::forge::ParallelExecutor::Result r = exec.runReduced(numPaths, generateInputs);
+        if (numPaths == 1000)
+        {
+            EXPECT_EQ(ref.outputSums[0], r.outputSums[0]) << "run " << run;
+        }
+    }
+    EXPECT_THROW(exec.runReduced(1000,
+                                 [](std::size_t path, double* inputs) {
+                                     if (path == 500)
+                                         throw std::runtime_error("generator failed");
+                                     generateInputs(path, inputs);
+                                 }),
+                 std::runtime_error);
+    xad::forge::ParallelExecutor::Result after = exec.runReduced(1000, generateInputs);
+    EXPECT_EQ(ref.outputSums[0], after.outputSums[0]);
+    EXPECT_EQ(ref.gradientSums[0], after.gradientSums[0]);
+}
+
+TEST(ParallelExecutorConstantsTest, RuntimeConstantsReachEveryWorker)
+{
+    // f(x) = x * 1.25 + 2, with 1.25 compiled as a runtime parameter
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD y = x * 1.25 + 2.0;
+    jit.registerOutput(y);
+
+    const xad::JITGraph& graph = jit.getGraph();
+    std::size_t scaleIndex = graph.const_pool.size();
+    for (std::size_t i = 0; i < graph.const_pool.size(); ++i)
+        if (graph.const_pool[i] == 1.25)
+            scaleIndex = i;
+    ASSERT_LT(scaleIndex, graph.const_pool.size());
+
+    xad::forge::ForgeBackend<double> backend;
+    backend.setRuntimeConstants(std::vector<std::size_t>(1, scaleIndex));
+    backend.compile(graph);
+    backend.setConstant(scaleIndex, 3.0);
+
+    const std::size_t numPaths = 300;
+    std::vector<double> outputs(numPaths), gradients(numPaths);
+    auto check = [&](double scale) {
+        for (std::size_t p = 0; p < numPaths; ++p)
+        {
+            EXPECT_NEAR(pathX(p) * scale + 2.0, outputs[p], 1e-10) << "scale " << scale << ", path " << p;
+            EXPECT_NEAR(scale, gradients[p], 1e-10) << "scale " << scale << ", path " << p;
+        }
+    };
+    auto generator = [](std::size_t path, double* inputs) { inputs[0] = pathX(path); };
+
+    // Workers start from the backend's constants, not the recorded 1.25
+    xad::forge::ParallelExecutor exec(backend, 4, 16);
+    exec.run(numPaths, generator, outputs.data(), gradients.data());
+    check(3.0);
+
+    // Changes after the worker buffers exist reach all of them
+    exec.setConstant(scaleIndex, -0.5);
+    exec.run(numPaths, generator, outputs.data(), gradients.data());
+    check(-0.5);
+
+    exec.loadConstants(graph);
+    exec.run(numPaths, generator, outputs.data(), gradients.data());
+    check(1.25);
+
+    EXPECT_THROW(exec.setConstant(scaleIndex == 0 ? 1 : 0, 0.0), std::invalid_argument);
+
+    // A backend attached to the kernel starts at the recorded values until
+    // the master's constants are copied over
+    xad::forge::ForgeBackend<double> worker(backend.kernel());
+    double input = 2.0, output = 0.0;
+    worker.setInput(0, &input);
+    worker.forward(&output);
+    EXPECT_NEAR(4.5, output, 1e-10);
+    worker.setConstants(backend.constants());
+    worker.forward(&output);
+    EXPECT_NEAR(8.0, output, 1e-10);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -16,6 +16,7 @@
 #include <cmath>
 #include <vector>
 #include <memory>
+#include <thread>
 
 namespace {
 
@@ -363,6 +364,251 @@ TEST_F(ScalarBackendTest, ManyReEvaluations)
     }
 }
 
+// =============================================================================
+// Forward-only evaluation (no adjoint sweep)
+// =============================================================================
+
+TEST_F(ScalarBackendTest, ForwardOnlyMatchesForwardAndBackward)
+{
+    std::vector<double> inputs = {2.0, 0.5, 1.0, 3.0, 4.5};
+
+    std::vector<double> refOutputs, refDerivatives;
+    computeReference(f3<xad::AD>, inputs, refOutputs, refDerivatives);
+
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(inputs[0]);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD y = f3(x);
+    jit.registerOutput(y);
+
+    xad::forge::ForgeBackend<double> backend;
+    backend.compile(jit.getGraph());
+
+    // Set the first input before the forward-only kernel exists, then
+    // interleave both kernels to check inputs stay in sync between them
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+    {
+        double inputVal = inputs[i];
+        backend.setInput(0, &inputVal);
+
+        double output;
+        backend.forward(&output);
+        EXPECT_NEAR(refOutputs[i], output, 1e-10)
+            << "Forward-only mismatch at input " << inputs[i];
+
+        double inputGradient;
+        backend.forwardAndBackward(&output, &inputGradient);
+        EXPECT_NEAR(refOutputs[i], output, 1e-10)
+            << "Forward mismatch at input " << inputs[i];
+        EXPECT_NEAR(refDerivatives[i], inputGradient, 1e-10)
+            << "Adjoint mismatch at input " << inputs[i];
+    }
+}
+
+// =============================================================================
+// Shared compiled kernel with per-thread buffers
+// =============================================================================
+
+TEST_F(ScalarBackendTest, SharedKernelAcrossThreads)
+{
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD y = x * x + 3.0 * x + 2.0;  // f(x) = x^2 + 3x + 2
+    jit.registerOutput(y);
+
+    // Compile once
+    xad::forge::ForgeBackend<double> master;
+    master.compile(jit.getGraph());
+    std::shared_ptr<const xad::forge::ForgeKernel> kernel = master.kernel();
+    ASSERT_TRUE(kernel != nullptr);
+
+    const int NUM_THREADS = 4;
+    const int NUM_EVALUATIONS = 250;
+    std::vector<int> failures(NUM_THREADS, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            // Each worker gets its own buffer on the shared kernel
+            xad::forge::ForgeBackend<double> worker(kernel);
+            for (int i = 0; i < NUM_EVALUATIONS; ++i)
+            {
+                double inputVal = static_cast<double>(t * NUM_EVALUATIONS + i) / 100.0 - 5.0;
+                worker.setInput(0, &inputVal);
+
+                double output;
+                double inputGradient;
+                worker.forwardAndBackward(&output, &inputGradient);
+
+                double expected = inputVal * inputVal + 3.0 * inputVal + 2.0;
+                double expectedDeriv = 2.0 * inputVal + 3.0;
+                if (std::abs(expected - output) > 1e-10 || std::abs(expectedDeriv - inputGradient) > 1e-10)
+                    ++failures[t];
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    for (int t = 0; t < NUM_THREADS; ++t)
+        EXPECT_EQ(0, failures[t]) << "Mismatches on thread " << t;
+
+    // The master backend still works on its own buffer
+    double inputVal = 2.0;
+    master.setInput(0, &inputVal);
+    double output;
+    master.forward(&output);
+    EXPECT_NEAR(12.0, output, 1e-10);
+}
+
+// =============================================================================
+// Runtime constants
+// =============================================================================
+
+TEST_F(ScalarBackendTest, SetConstantWithoutRecompiling)
+{
+    // f(x) = x * 1.25 + 2, with 1.25 compiled as a runtime parameter
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD y = x * 1.25 + 2.0;
+    jit.registerOutput(y);
+
+    const xad::JITGraph& graph = jit.getGraph();
+    std::size_t scaleIndex = graph.const_pool.size();
+    for (std::size_t i = 0; i < graph.const_pool.size(); ++i)
+        if (graph.const_pool[i] == 1.25)
+            scaleIndex = i;
+    ASSERT_LT(scaleIndex, graph.const_pool.size());
+
+    xad::forge::ForgeBackend<double> backend;
+    backend.setRuntimeConstants(std::vector<std::size_t>(1, scaleIndex));
+    backend.compile(graph);
+    std::shared_ptr<const xad::forge::ForgeKernel> kernel = backend.kernel();
+
+    double inputVal = 2.0, output = 0.0, inputGradient = 0.0;
+    backend.setInput(0, &inputVal);
+    backend.forwardAndBackward(&output, &inputGradient);
+    EXPECT_NEAR(4.5, output, 1e-10);  // starts at the recorded value
+    EXPECT_NEAR(1.25, inputGradient, 1e-10);
+
+    for (double scale : {-1.0, 0.5, 7.0})
+    {
+        backend.setConstant(scaleIndex, scale);
+        backend.forwardAndBackward(&output, &inputGradient);
+        EXPECT_NEAR(2.0 * scale + 2.0, output, 1e-10) << "scale = " << scale;
+        EXPECT_NEAR(scale, inputGradient, 1e-10) << "scale = " << scale;
+
+        backend.forward(&output);
+        EXPECT_NEAR(2.0 * scale + 2.0, output, 1e-10) << "forward-only, scale = " << scale;
+    }
+    EXPECT_EQ(kernel, backend.kernel()) << "setConstant must not recompile";
+
+    // Constants that were not made runtime parameters cannot be changed
+    std::size_t literalIndex = scaleIndex == 0 ? 1 : 0;
+    if (literalIndex < graph.const_pool.size())
+    {
+        EXPECT_THROW(backend.setConstant(literalIndex, 0.0), std::invalid_argument);
+    }
+}
+
+TEST_F(ScalarBackendTest, CompileStatsAreRecorded)
+{
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD y = f3(x);
+    jit.registerOutput(y);
+
+    xad::forge::ForgeBackend<double> backend;
+    backend.compile(jit.getGraph());
+
+    xad::forge::CompileStats stats = backend.kernel()->compileStats();
+    EXPECT_EQ(jit.getGraph().nodeCount() + jit.getGraph().const_pool.size(), stats.nodes);
+    EXPECT_GT(stats.translateMs, 0.0);
+    EXPECT_GT(stats.compileMs, 0.0);
+    EXPECT_EQ(0.0, stats.forwardCompileMs) << "forward-only kernel is compiled lazily";
+
+    double inputVal = 0.5, output = 0.0;
+    backend.setInput(0, &inputVal);
+    backend.forward(&output);
+    EXPECT_GT(backend.kernel()->compileStats().forwardCompileMs, 0.0);
+}
+
+TEST_F(ScalarBackendTest, CompactModeReleasesGraph)
+{
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0);
+    jit.registerInput(x);
+    jit.newRecording();
+    xad::AD y = f3(x);
+    jit.registerOutput(y);
+
+    xad::forge::ForgeBackend<double> full, compact;
+    compact.setCompact(true);
+    full.compile(jit.getGraph());
+    compact.compile(jit.getGraph());
+
+    EXPECT_FALSE(full.kernel()->compileResourcesReleased());
+    EXPECT_TRUE(compact.kernel()->compileResourcesReleased());
+    const xad::forge::MemoryUsage before = full.memoryUsage();
+    const xad::forge::MemoryUsage after = compact.memoryUsage();
+    EXPECT_GT(before.graphBytes, 0u);
+    EXPECT_LT(after.graphBytes, before.graphBytes);
+    EXPECT_LT(after.total(), before.total());
+
+    for (double inputVal : {-1.0, 0.5, 3.0})
+    {
+        double out1 = 0.0, out2 = 0.0, grad1 = 0.0, grad2 = 0.0;
+        full.setInput(0, &inputVal);
+        compact.setInput(0, &inputVal);
+        full.forwardAndBackward(&out1, &grad1);
+        compact.forwardAndBackward(&out2, &grad2);
+        EXPECT_EQ(out1, out2);
+        EXPECT_EQ(grad1, grad2);
+        compact.forward(&out2);
+        EXPECT_EQ(out1, out2);
+    }
+
+    // No new buffers can be created from a compacted kernel
+    EXPECT_THROW(xad::forge::ForgeBackend<double> worker(compact.kernel()), std::runtime_error);
+}
+
+TEST_F(ScalarBackendTest, CompactModeKeepsOutputAdjoints)
+{
+    // Two outputs, so output adjoints need the VJP kernel: f1 = x*y, f2 = x + y*y
+    xad::JITCompiler<double, 1> jit;
+    xad::AD x(1.0), y(2.0);
+    jit.registerInput(x);
+    jit.registerInput(y);
+    jit.newRecording();
+    xad::AD f1 = x * y;
+    xad::AD f2 = x + y * y;
+    jit.registerOutput(f1);
+    jit.registerOutput(f2);
+
+    xad::forge::ForgeBackend<double> compact;
+    compact.setCompact(true);
+    compact.compile(jit.getGraph());
+    EXPECT_TRUE(compact.kernel()->compileResourcesReleased());
+    EXPECT_GT(compact.kernel()->compileStats().vjpCompileMs, 0.0) << "VJP kernel is compiled before release";
+
+    const double inputs[2] = {1.5, -2.0};
+    const double adjoints[2] = {2.0, 0.5};
+    double outputs[2], gradients[2];
+    compact.setInputs(inputs);
+    compact.forwardAndBackward(outputs, adjoints, gradients);
+    EXPECT_NEAR(1.5 * -2.0, outputs[0], 1e-12);
+    EXPECT_NEAR(1.5 + 4.0, outputs[1], 1e-12);
+    EXPECT_NEAR(2.0 * -2.0 + 0.5, gradients[0], 1e-12);
+    EXPECT_NEAR(2.0 * 1.5 + 0.5 * 2.0 * -2.0, gradients[1], 1e-12);
+}
+
 // =============================================================================
 // Reset and recompile test
 // =============================================================================
@@ -0,0 +1,201 @@
+/*
+ * xad-forge Tiered Backend Test Suite
+ *
+ * Tests TieredForgeBackend promotion between execution tiers:
+ * - Results are identical on every tier
+ * - Promotions follow the cost model and are recorded for inspection
+ * - Bulk evaluation reaches the SIMD tier when it pays off
+ *
+ * Copyright (c) 2025 The xad-forge Authors
+ * https://github.com/da-roth/xad-forge
+ * SPDX-License-Identifier: Zlib
+ */
+
+#include <xad-forge/TieredForgeBackend.hpp>
+#include <XAD/XAD.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include <memory>
+
+namespace {
+
+typedef xad::forge::TieredForgeBackend<double> Tiered;
+
+void checkPaths(std::size_t numPaths, const std::vector<double>& inputs, const std::vector<double>& outputs,
+                const std::vector<double>& gradients)
+{
+    for (std::size_t p = 0; p < numPaths; ++p)
+    {
+        double x = inputs[p], y = inputs[numPaths + p];
+        EXPECT_NEAR(x * y + x * x, outputs[p], 1e-10) << "Output mismatch at path " << p;
+        EXPECT_NEAR(y + 2.0 * x, gradients[p], 1e-10) << "dx mismatch at path " << p;
+        EXPECT_NEAR(x, gradients[numPaths + p], 1e-10) << "dy mismatch at path " << p;
+    }
+}
+
+} // anonymous namespace
+
+class TieredBackendTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        // f(x, y) = x*y + x^2, df/dx = y + 2x, df/dy = x
+        xad::AD x(1.0), y(2.0);
+        jit.registerInput(x);
+        jit.registerInput(y);
+        jit.newRecording();
+        xad::AD z = x * y + x * x;
+        jit.registerOutput(z);
+    }
+
+    void makeInputs(std::size_t numPaths, std::vector<double>& inputs)
+    {
+        inputs.resize(2 * numPaths);
+        for (std::size_t p = 0; p < numPaths; ++p)
+        {
+            inputs[p] = static_cast<double>(p % 37) / 8.0 - 2.0;
+            inputs[numPaths + p] = static_cast<double>(p % 11) / 4.0 + 0.5;
+        }
+    }
+
+    xad::JITCompiler<double, 1> jit;
+};
+
+TEST_F(TieredBackendTest, StaysOnInterpreterWhenCompileIsExpensive)
+{
+    xad::forge::TieringPolicy policy;
+    policy.compileNsPerNode = 1e12;
+    Tiered backend(policy);
+    backend.compile(jit.getGraph());
+
+    for (int i = 0; i < 20; ++i)
+    {
+        double x = 0.1 * i, y = 1.0 - 0.05 * i;
+        backend.setInput(0, &x);
+        backend.setInput(1, &y);
+        double output = 0.0, gradients[2] = {0.0, 0.0};
+        backend.forwardAndBackward(&output, gradients);
+        EXPECT_NEAR(x * y + x * x, output, 1e-10);
+        EXPECT_NEAR(y + 2.0 * x, gradients[0], 1e-10);
+        EXPECT_NEAR(x, gradients[1], 1e-10);
+    }
+
+    EXPECT_EQ(Tiered::Interpreter, backend.tier());
+    EXPECT_TRUE(backend.promotions().empty());
+    EXPECT_EQ(20u, backend.pathsOnTier(Tiered::Interpreter));
+}
+
+TEST_F(TieredBackendTest, FreeCompilePromotesImmediately)
+{
+    xad::forge::TieringPolicy policy;
+    policy.compileNsPerNode = 0.0;
+    Tiered backend(policy);
+    backend.compile(jit.getGraph());
+
+    // Inputs set before the promotion carry over to the compiled kernel
+    double x = 1.5, y = -0.5;
+    backend.setInput(0, &x);
+    backend.setInput(1, &y);
+
+    double output = 0.0, gradients[2] = {0.0, 0.0};
+    backend.forwardAndBackward(&output, gradients);
+    EXPECT_NEAR(x * y + x * x, output, 1e-10);
+    EXPECT_NEAR(y + 2.0 * x, gradients[0], 1e-10);
+    EXPECT_NEAR(x, gradients[1], 1e-10);
+
+    EXPECT_EQ(Tiered::ScalarKernel, backend.tier());
+    ASSERT_EQ(1u, backend.promotions().size());
+    EXPECT_EQ(Tiered::Interpreter, backend.promotions()[0].from);
+    EXPECT_EQ(Tiered::ScalarKernel, backend.promotions()[0].to);
+    EXPECT_FALSE(backend.promotions()[0].reason.empty());
+}
+
+TEST_F(TieredBackendTest, BulkEvaluateAcrossPromotions)
+{
+    const std::size_t numPaths = 5003;
+    std::vector<double> inputs;
+    makeInputs(numPaths, inputs);
+
+    xad::forge::TieringPolicy policy;
+    policy.compileNsPerNode = 0.0;
+    Tiered backend(policy);
+    backend.compile(jit.getGraph());
+
+    std::vector<double> outputs(numPaths), gradients(2 * numPaths);
+    backend.evaluate(numPaths, inputs.data(), outputs.data(), gradients.data());
+    checkPaths(numPaths, inputs, outputs, gradients);
+
+    // Each promotion moves up exactly one tier
+    const std::vector<Tiered::Promotion>& log = backend.promotions();
+    ASSERT_FALSE(log.empty());
+    for (std::size_t i = 0; i < log.size(); ++i)
+    {
+        EXPECT_EQ(static_cast<int>(log[i].from) + 1, static_cast<int>(log[i].to));
+        EXPECT_GE(log[i].actualCompileMs, 0.0);
+    }
+    EXPECT_EQ(log.back().to, backend.tier());
+
+    std::size_t total = 0;
+    for (int t = Tiered::Interpreter; t <= Tiered::VectorKernel; ++t)
+        total += backend.pathsOnTier(static_cast<Tiered::Tier>(t));
+    EXPECT_EQ(numPaths, total);
+}
+
+TEST_F(TieredBackendTest, ForcedPromotion)
+{
+    const std::size_t numPaths = 17;
+    std::vector<double> inputs;
+    makeInputs(numPaths, inputs);
+
+    Tiered backend;
+    backend.compile(jit.getGraph());
+    backend.promoteTo(Tiered::VectorKernel);
+    EXPECT_NE(Tiered::Interpreter, backend.tier());
+
+    std::vector<double> outputs(numPaths), gradients(2 * numPaths);
+    backend.evaluate(numPaths, inputs.data(), outputs.data(), gradients.data());
+    checkPaths(numPaths, inputs, outputs, gradients);
+}
+
+TEST_F(TieredBackendTest, FullCompileBlendsIntoCompileModel)
+{
+    xad::forge::TieringPolicy policy;
+    policy.compileNsPerNode = 0.0;
+    Tiered backend(policy);
+    backend.compile(jit.getGraph());
+    backend.promoteTo(Tiered::ScalarKernel);
+
+    // Moving average with the default weight of one half
+    const xad::JITGraph& graph = jit.getGraph();
+    const double nodes = static_cast<double>(graph.nodeCount() + graph.const_pool.size());
+    const double measured = backend.promotions()[0].actualCompileMs * 1e6 / nodes;
+    EXPECT_NEAR(0.5 * measured, backend.policy().compileNsPerNode, 1e-9 * measured);
+
+    // Compiling the vector tier reuses the translation and leaves the model alone
+    const double calibrated = backend.policy().compileNsPerNode;
+    backend.promoteTo(Tiered::VectorKernel);
+    EXPECT_EQ(calibrated, backend.policy().compileNsPerNode);
+}
+
+TEST_F(TieredBackendTest, CacheHitKeepsCompileModel)
+{
+    xad::forge::KernelCache cache;
+    cache.getOrCompile(jit.getGraph(), FORGE_INSTRUCTION_SET_SSE2_SCALAR);
+
+    xad::forge::TieringPolicy policy;
+    policy.compileNsPerNode = 0.0;
+    Tiered backend(policy);
+    backend.setKernelCache(&cache);
+    backend.compile(jit.getGraph());
+    backend.promoteTo(Tiered::ScalarKernel);
+
+    EXPECT_EQ(1u, cache.hits());
+    EXPECT_EQ(0.0, backend.policy().compileNsPerNode);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}